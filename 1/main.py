@@ -58,6 +58,13 @@ class Value:
         out._backward = backward
         return out
 
+    def leaky_relu(self):
+        out = Value(self.value if self.value > 0 else 0.01 * self.value, (self,), op='leaky_relu')
+        def backward():
+            self.grad += out.grad * (1 if self.value > 0 else 0.01)
+        out._backward = backward
+        return out
+
     def repr(self):
         return f"Value={self.value}"
 
@@ -129,34 +136,34 @@ class MLP:
                     w.reset_grad()
                 neuron.b.reset_grad()
 
-input_data = [Value(1.0), Value(2.0), Value(3.0)]
-expected_output = [Value(0.5)]
-mlp = MLP(nin=3, nout=1, nhidden=10, nhin=10)
-loss_history = []
-
-for i in range(1000):
-    mlp.reset_grads()
-    output = mlp(input_data)
-    loss = Value(0.0)
-    for o, e in zip(output, expected_output):
-        loss = loss + (o - e) ** Value(2.0)
-    loss.backward()
-    for layer in mlp.layers:
-        for neuron in layer.neurons:
-            for j in range(len(neuron.w)):
-                neuron.w[j].value -= 0.01 * neuron.w[j].grad
-            neuron.b.value -= 0.01 * neuron.b.grad
-    # visualize the parameters
-    if i % 100 == 0:
-        print(f"Iteration {i}, Loss: {loss.value}")
-    loss_history.append(loss.value)
-
-# Plotting the losss history with matplotlib
-import matplotlib.pyplot as plt
-plt.plot(loss_history)
-plt.xlabel('Iteration')
-plt.ylabel('Loss')
-plt.title('Loss History')
-# save as png
-plt.savefig('loss_history.png')
-
+if __name__ == "__main__":
+    input_data = [Value(1.0), Value(2.0), Value(3.0)]
+    expected_output = [Value(0.5)]
+    mlp = MLP(nin=3, nout=1, nhidden=10, nhin=10)
+    loss_history = []
+
+    for i in range(1000):
+        mlp.reset_grads()
+        output = mlp(input_data)
+        loss = Value(0.0)
+        for o, e in zip(output, expected_output):
+            loss = loss + (o - e) ** Value(2.0)
+        loss.backward()
+        for layer in mlp.layers:
+            for neuron in layer.neurons:
+                for j in range(len(neuron.w)):
+                    neuron.w[j].value -= 0.01 * neuron.w[j].grad
+                neuron.b.value -= 0.01 * neuron.b.grad
+        # visualize the parameters
+        if i % 100 == 0:
+            print(f"Iteration {i}, Loss: {loss.value}")
+        loss_history.append(loss.value)
+
+    # Plotting the losss history with matplotlib
+    import matplotlib.pyplot as plt
+    plt.plot(loss_history)
+    plt.xlabel('Iteration')
+    plt.ylabel('Loss')
+    plt.title('Loss History')
+    # save as png
+    plt.savefig('loss_history.png')
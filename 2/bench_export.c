@@ -0,0 +1,53 @@
+// Time of the graph exporters on a chain of NUM_VALUES values (leaves summed
+// one by one, like an accumulation of callNeuron), far deeper than a
+// recursive walk could go. Every format is exported twice, the second run
+// reuses the marks left by the first one.
+//
+// gcc -O2 bench_export.c -lm -o bench_export
+
+#define main engine2_main
+#include "main.c"
+#undef main
+
+#include <time.h>
+
+#define NUM_VALUES 1000000
+
+int main() {
+    // Values and parents outside of the pools, which only hold one small forward pass
+    BackpropValue *values = malloc(sizeof(BackpropValue) * NUM_VALUES);
+    BackpropValue **parents = malloc(sizeof(BackpropValue*) * NUM_VALUES);
+
+    createValue(0.0f, &values[0]);
+    BackpropValue *output = &values[0];
+    for(int i = 1; i + 1 < NUM_VALUES; i += 2) {
+        BackpropValue *leaf = &values[i];
+        BackpropValue *sum = &values[i + 1];
+        createValue(1.0f, leaf);
+        createValue(0.0f, sum);
+        sum->parents = &parents[i];
+        sum->parents[0] = &values[i - 1];
+        sum->parents[1] = leaf;
+        sum->num_parents = 2;
+        sum->operation = '+';
+        sum->value = values[i - 1].value + leaf->value;
+        output = sum;
+    }
+
+    const char *filenames[] = {"graph.dot", "graph_summary.dot", "graph.bpg"};
+    const char *names[] = {"dot", "dot summary", "binary"};
+    int formats[] = {GRAPH_DOT, GRAPH_DOT_SUMMARY, GRAPH_BINARY};
+    printf("%d values\n", values_count);
+    for(int f = 0; f < 3; f++) {
+        for(int run = 0; run < 2; run++) {
+            clock_t start = clock();
+            writeGraphFile(output, filenames[f], formats[f]);
+            printf("%-11s run %d: %.2f s\n", names[f], run, (double)(clock() - start) / CLOCKS_PER_SEC);
+        }
+        remove(filenames[f]);
+    }
+
+    free(parents);
+    free(values);
+    return 0;
+}
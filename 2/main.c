@@ -11,12 +11,14 @@ typedef struct BackpropValue {
     int num_parents;
     char operation;
     float grad;
+    int graph_mark; // graph_epoch of the last export that reached this value
 } BackpropValue;
 
 typedef struct Neuron {
     struct BackpropValue **w;
     int nin;
     struct BackpropValue *b;
+    char activation; // 'T' for tanh, 'R' for leaky ReLU
 } Neuron;
 
 typedef struct Layer {
@@ -30,20 +32,41 @@ typedef struct NN {
     int nin;
     int nout;
     int nhin; // Number of hidden neurons in every layer of the hidden layers
+
+    // Gradient checkpointing: when > 0, only the inputs of every
+    // checkpoint_every-th layer are kept after the forward pass, the rest is
+    // recomputed during backwardCheckpointed
+    int checkpoint_every;
+    struct Checkpoint *checkpoints;
+    int n_checkpoints;
 } NN;
 
+typedef struct Checkpoint {
+    BackpropValue **values; // detached copies of the segment inputs
+    int n;
+    int first_layer; // first layer of the segment
+    int backprop_mark; // pool indexes to rewind to when recomputing
+    int parents_mark;
+} Checkpoint;
+
 BackpropValue **parameters;
 int parameters_length = 0;
 
+int values_count = 0; // Number of ids given by createValue
+
 #define MAX_BACKPROP_POOL_SIZE 4096
 BackpropValue backprop_pool[MAX_BACKPROP_POOL_SIZE];
 int backprop_pool_index = 0;
+int backprop_pool_peak = 0; // highest number of pool values alive at once
 
 BackpropValue *getBackpropPtr() {
     if (backprop_pool_index >= MAX_BACKPROP_POOL_SIZE) {
         fprintf(stderr, "Backprop pool exhausted!\n");
         exit(EXIT_FAILURE);
     }
+    if (backprop_pool_index + 1 > backprop_pool_peak) {
+        backprop_pool_peak = backprop_pool_index + 1;
+    }
     return &backprop_pool[backprop_pool_index++];
 }
 
@@ -62,6 +85,14 @@ BackpropValue **getParentPtr(int num) {
     return ptr;
 }
 
+// Drop every value of the previous forward pass, the parameters are not
+// in the pools so they are kept
+int resetPools() {
+    backprop_pool_index = 0;
+    parents_pool_index = 0;
+    return 0;
+}
+
 int displayValueWithDepth(BackpropValue *bv, int depth) {
     printf("%i Value: %f, Parents: %p, NumParents: %d, Operation: %c, Grad : %f\n",
            bv->id, bv->value, bv->parents, bv->num_parents,
@@ -121,6 +152,17 @@ int tanhValue(BackpropValue *a, BackpropValue *result) {
     return 0;
 }
 
+// Leaky ReLU, same slope as the MLP in 3/
+int reluValue(BackpropValue *a, BackpropValue *result) {
+    result->value = (a->value > 0) ? a->value : 0.01f * a->value;
+
+    result->parents = getParentPtr(1);
+    result->parents[0] = a;
+    result->num_parents = 1;
+    result->operation = 'R';
+    return 0;
+}
+
 int buildTopo(BackpropValue *bv, BackpropValue ***topo, int *index) {
     for(int i = 0; i < bv->num_parents; i++) {
         int found = 0;
@@ -154,6 +196,8 @@ int _backwardValue(BackpropValue *bv) {
     } else if(bv->operation == 'T') {
         float tanh_val = tanhf(bv->parents[0]->value);
         bv->parents[0]->grad += bv->grad * (1 - tanh_val * tanh_val);
+    } else if(bv->operation == 'R') {
+        bv->parents[0]->grad += bv->grad * ((bv->parents[0]->value > 0) ? 1.0f : 0.01f);
     } else {
         return -1; // Unknown operation
     }
@@ -191,43 +235,85 @@ int backwardValue(BackpropValue *bv) {
     return 0;
 }
 
+// Same as backwardValue but for several outputs at once, their grad must
+// already be set (used to continue the backward pass of a recomputed segment)
+int backwardValues(BackpropValue **bvs, int n) {
+    BackpropValue **topo = NULL;
+    int topo_length = 0;
+
+    for(int i = 0; i < n; i++) {
+        buildTopo(bvs[i], &topo, &topo_length);
+        topo = realloc(topo, sizeof(BackpropValue *) * (topo_length + 1));
+        topo[topo_length] = bvs[i];
+        topo_length++;
+    }
+
+    for(int i = topo_length - 1; i >= 0; i--) {
+        _backwardValue(topo[i]);
+    }
+
+    free(topo);
+    return 0;
+}
+
+int zeroGrads() {
+    for(int i = 0; i < parameters_length; i++) {
+        parameters[i]->grad = 0.0f;
+    }
+    return 0;
+}
+
 int createValue(float value, BackpropValue *bv) {
-    static int id_counter = 0; // Static counter to assign unique IDs
-    
-    bv->id = id_counter++;
+    bv->id = values_count++; // Unique IDs
     bv->value = value;
     bv->parents = NULL;
     bv->num_parents = 0;
     bv->operation = '_'; // No operation
     bv->grad = 0.0f; // Initialize gradient to 0
+    bv->graph_mark = 0;
+    return 0;
+}
+
+// Parameter i is initialised from (init_seed, i) only, not from the state of rand()
+unsigned long long init_seed = 91;
+
+// splitmix64 of the counter, a pure function like the Philox generator of 3/
+float randomParameter(unsigned long long index) {
+    unsigned long long z = init_seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+    return (float)(z >> 40) / (float)(1 << 24) * 2.0f - 1.0f; // Random float in [-1, 1)
+}
+
+int parameters_capacity = 0;
+
+int addParameter(BackpropValue *bv) {
+    if (parameters_length == parameters_capacity) {
+        parameters_capacity = (parameters_capacity == 0) ? 1024 : parameters_capacity * 2;
+        parameters = realloc(parameters, sizeof(BackpropValue*) * parameters_capacity);
+    }
+    parameters[parameters_length++] = bv;
     return 0;
 }
 
 int createNeuron(int nin, Neuron *n) {
     n->nin = nin;
     n->w = malloc(sizeof(BackpropValue*) * nin);
-    for(int i = 0; i < nin; i++) {
-        // random float between -1.0 and 1.0
-        float random_value = ((float)rand() / RAND_MAX) * 2.0f - 1.0f; // Random float in [-1, 1]
-        n->w[i] = malloc(sizeof(BackpropValue));
-
-        // add to parameters
 
-        parameters_length++;
-        parameters = realloc(parameters, sizeof(BackpropValue*) * parameters_length);
-        parameters[parameters_length - 1] = n->w[i];
-        
-        createValue(random_value, n->w[i]);
+    // the weights and the bias of a neuron are one block
+    BackpropValue *values = malloc(sizeof(BackpropValue) * (nin + 1));
+    for(int i = 0; i < nin; i++) {
+        n->w[i] = &values[i];
+        createValue(randomParameter(parameters_length), n->w[i]);
+        addParameter(n->w[i]);
     }
-    float random_bias = ((float)rand() / RAND_MAX) * 2.0f - 1.0f; // Random float in [-1, 1]
-    n->b = malloc(sizeof(BackpropValue));
-    
-    // add to parameters
-    parameters_length++;
-    parameters = realloc(parameters, sizeof(BackpropValue*) * parameters_length);
-    parameters[parameters_length - 1] = n->b;
 
-    createValue(random_bias, n->b);
+    n->b = &values[nin];
+    createValue(randomParameter(parameters_length), n->b);
+    addParameter(n->b);
+
+    n->activation = 'T';
     return 0;
 }
 
@@ -246,7 +332,7 @@ int callNeuron(Neuron *n, BackpropValue **inputs, BackpropValue *output) {
         act = getBackpropPtr();
         createValue(0.0f, act); // Initialize activation value
         
-        BackpropValue *weighted_input = malloc(sizeof(BackpropValue));
+        BackpropValue *weighted_input = getBackpropPtr();
         createValue(0.0f, weighted_input);
         multiplyValues(n->w[i], inputs[i], weighted_input);
         
@@ -254,13 +340,17 @@ int callNeuron(Neuron *n, BackpropValue **inputs, BackpropValue *output) {
     }
 
     // Add the bias
-    BackpropValue *final_act = malloc(sizeof(BackpropValue));
+    BackpropValue *final_act = getBackpropPtr();
     createValue(0.0f, final_act); // Initialize final activation value
     addValues(act, n->b, final_act);
 
-    // Apply activation function (tanh)
+    // Apply activation function (tanh by default)
     createValue(0.0f, output); // Initialize output value
-    tanhValue(final_act, output);
+    if (n->activation == 'R') {
+        reluValue(final_act, output);
+    } else {
+        tanhValue(final_act, output);
+    }
     return 0;
 }
 
@@ -276,7 +366,7 @@ int createLayer(int nin, int nout, Layer *l) {
 
 int callLayer(Layer *l, BackpropValue **inputs, BackpropValue **outputs) {
     for(int i = 0; i < l->nout; i++) {
-        outputs[i] = malloc(sizeof(BackpropValue));
+        outputs[i] = getBackpropPtr();
         createValue(0.0f, outputs[i]); // Initialize output value
         callNeuron(l->neurons[i], inputs, outputs[i]);
     }
@@ -294,6 +384,9 @@ int createNN(int nin, int nout, int n_layers, NN *nn, int nhin) {
     nn->n_layers = n_layers;
     nn->layers = malloc(sizeof(Layer*) * n_layers);
     nn->nhin = nhin;
+    nn->checkpoint_every = 0;
+    nn->checkpoints = NULL;
+    nn->n_checkpoints = 0;
 
     nn->layers[0] = malloc(sizeof(Layer));
     createLayer(nin, nhin, nn->layers[0]); // Input layer
@@ -309,56 +402,281 @@ int createNN(int nin, int nout, int n_layers, NN *nn, int nhin) {
     return 0;
 }
 
-int callNN(NN *nn, BackpropValue **inputs, BackpropValue **outputs) {
-    // call the first layer
-    BackpropValue **hidden_outputs = malloc(sizeof(BackpropValue*) * nn->nhin);
-    callLayer(nn->layers[0], inputs, hidden_outputs);
+int layerOutputs(NN *nn, int layer) {
+    return (layer == nn->n_layers - 1) ? nn->nout : nn->nhin;
+}
 
-    // call the hidden layers
-    for(int i = 1; i < nn->n_layers - 1; i++) {
-        BackpropValue **new_hidden_outputs = malloc(sizeof(BackpropValue*) * nn->nhin);
+// Call the layers first..last-1, outputs must have room for layerOutputs(nn, last - 1)
+int callLayers(NN *nn, int first, int last, BackpropValue **inputs, BackpropValue **outputs) {
+    BackpropValue **hidden_outputs = inputs;
+
+    for(int i = first; i < last - 1; i++) {
+        BackpropValue **new_hidden_outputs = malloc(sizeof(BackpropValue*) * layerOutputs(nn, i));
         callLayer(nn->layers[i], hidden_outputs, new_hidden_outputs);
 
-        free(hidden_outputs);
+        if (hidden_outputs != inputs) free(hidden_outputs);
         hidden_outputs = new_hidden_outputs;
     }
 
-    // call the output layer
-    callLayer(nn->layers[nn->n_layers - 1], hidden_outputs, outputs);
-    free(hidden_outputs);
+    callLayer(nn->layers[last - 1], hidden_outputs, outputs);
+    if (hidden_outputs != inputs) free(hidden_outputs);
+
+    return 0;
+}
+
+int freeCheckpoints(NN *nn) {
+    for(int i = 0; i < nn->n_checkpoints; i++) {
+        // the first checkpoint points to the caller's inputs
+        if (i > 0) {
+            for(int j = 0; j < nn->checkpoints[i].n; j++) {
+                free(nn->checkpoints[i].values[j]);
+            }
+        }
+        free(nn->checkpoints[i].values);
+    }
+    free(nn->checkpoints);
+    nn->checkpoints = NULL;
+    nn->n_checkpoints = 0;
+    return 0;
+}
+
+// Forward pass that keeps only the inputs of each segment of checkpoint_every
+// layers. The interior of every segment but the last one goes back to the pools
+int callNNCheckpointed(NN *nn, BackpropValue **inputs, BackpropValue **outputs) {
+    int k = nn->checkpoint_every;
+
+    freeCheckpoints(nn);
+    nn->n_checkpoints = (nn->n_layers + k - 1) / k;
+    nn->checkpoints = malloc(sizeof(Checkpoint) * nn->n_checkpoints);
+
+    nn->checkpoints[0].n = nn->nin;
+    nn->checkpoints[0].values = malloc(sizeof(BackpropValue*) * nn->nin);
+    for(int i = 0; i < nn->nin; i++) {
+        nn->checkpoints[0].values[i] = inputs[i];
+    }
+
+    for(int s = 0; s < nn->n_checkpoints; s++) {
+        Checkpoint *cp = &nn->checkpoints[s];
+        cp->first_layer = s * k;
+        cp->backprop_mark = backprop_pool_index;
+        cp->parents_mark = parents_pool_index;
+
+        if (s == nn->n_checkpoints - 1) {
+            callLayers(nn, cp->first_layer, nn->n_layers, cp->values, outputs);
+            break;
+        }
+
+        Checkpoint *next = &nn->checkpoints[s + 1];
+        next->n = layerOutputs(nn, cp->first_layer + k - 1);
+        next->values = malloc(sizeof(BackpropValue*) * next->n);
+
+        BackpropValue **segment_outputs = malloc(sizeof(BackpropValue*) * next->n);
+        callLayers(nn, cp->first_layer, cp->first_layer + k, cp->values, segment_outputs);
+
+        for(int i = 0; i < next->n; i++) {
+            next->values[i] = malloc(sizeof(BackpropValue));
+            createValue(segment_outputs[i]->value, next->values[i]);
+        }
+        free(segment_outputs);
+
+        backprop_pool_index = cp->backprop_mark;
+        parents_pool_index = cp->parents_mark;
+    }
+
+    return 0;
+}
+
+int callNN(NN *nn, BackpropValue **inputs, BackpropValue **outputs) {
+    if (nn->checkpoint_every > 0) {
+        return callNNCheckpointed(nn, inputs, outputs);
+    }
+    return callLayers(nn, 0, nn->n_layers, inputs, outputs);
+}
+
+// Backward pass for a loss computed on top of callNNCheckpointed. The last
+// segment is still in memory, every other one is recomputed from its
+// checkpoint, starting from the end. The graph of the forward pass is no
+// longer valid after this.
+int backwardCheckpointed(NN *nn, BackpropValue *loss) {
+    zeroGrads();
+    resetGrad(loss);
+    backwardValue(loss);
+
+    for(int s = nn->n_checkpoints - 2; s >= 0; s--) {
+        Checkpoint *cp = &nn->checkpoints[s];
+        Checkpoint *next = &nn->checkpoints[s + 1];
+
+        backprop_pool_index = cp->backprop_mark;
+        parents_pool_index = cp->parents_mark;
+
+        BackpropValue **segment_outputs = malloc(sizeof(BackpropValue*) * next->n);
+        callLayers(nn, cp->first_layer, next->first_layer, cp->values, segment_outputs);
+
+        for(int i = 0; i < next->n; i++) {
+            segment_outputs[i]->grad = next->values[i]->grad;
+        }
+        backwardValues(segment_outputs, next->n);
+        free(segment_outputs);
+    }
 
     return 0;
 }
 
-void dumpGraphviz(FILE *f, BackpropValue *v, int *visited, int max_nodes) {
-    if (visited[v->id]) return;
-    visited[v->id] = 1;
+#define GRAPH_DOT 0
+#define GRAPH_DOT_SUMMARY 1 // accumulation chains of '+' and '*' become one node
+#define GRAPH_BINARY 2
+
+// A '+' whose first parent is also a '+' is the end of an accumulation
+// chain, like the ones built by callNeuron and lossFunction
+int isChainHead(BackpropValue *v) {
+    return v->operation == '+' && v->parents[0]->operation == '+';
+}
+
+// Every export stamps the values it reaches with its own epoch instead of
+// indexing an array by id, so it only costs memory for its stack. Parameters
+// left out of a summary are stamped with graph_epoch + 1.
+int graph_epoch = 0;
+
+int isParameter(BackpropValue *v) {
+    return v->graph_mark == graph_epoch + 1;
+}
 
-    fprintf(f, "v%d [label=\"id:%d\\nval:%.2f\\ngrad:%.2f\\nop:%c\"];\n",
-            v->id, v->id, v->value, v->grad, v->operation);
+int pushValue(BackpropValue ***stack, int *length, int *capacity, BackpropValue *v) {
+    if (v->graph_mark >= graph_epoch) return 0;
+    v->graph_mark = graph_epoch;
 
-    for (int i = 0; i < v->num_parents; i++) {
-        fprintf(f, "v%d -> v%d;\n", v->parents[i]->id, v->id);
-        dumpGraphviz(f, v->parents[i], visited, max_nodes);
+    if (*length == *capacity) {
+        *capacity *= 2;
+        *stack = realloc(*stack, sizeof(BackpropValue*) * (*capacity));
     }
+    (*stack)[(*length)++] = v;
+    return 0;
 }
 
-void writeDotFile(BackpropValue *output, const char *filename, int total_values) {
-    FILE *f = fopen(filename, "w");
+// Leaves that are parameters are left out of the summary
+int markParameters() {
+    for(int i = 0; i < parameters_length; i++) {
+        parameters[i]->graph_mark = graph_epoch + 1;
+    }
+    return 0;
+}
+
+// Record of the binary dump, after the "BPG1" magic:
+// id, value, grad, operation, num_parents, then the id of every parent
+int writeBinaryValue(FILE *f, BackpropValue *v) {
+    int num_parents = v->num_parents;
+    fwrite(&v->id, sizeof(int), 1, f);
+    fwrite(&v->value, sizeof(float), 1, f);
+    fwrite(&v->grad, sizeof(float), 1, f);
+    fwrite(&v->operation, sizeof(char), 1, f);
+    fwrite(&num_parents, sizeof(int), 1, f);
+    for (int i = 0; i < num_parents; i++) {
+        fwrite(&v->parents[i]->id, sizeof(int), 1, f);
+    }
+    return 0;
+}
+
+// Summary node of the chain ending at head, its parents are the non
+// parameter operands of every term
+int writeChain(FILE *f, BackpropValue *head, BackpropValue ***stack, int *length, int *capacity) {
+    int terms = 0;
+    BackpropValue *v = head;
+    while (1) {
+        BackpropValue *term = v->parents[1];
+        BackpropValue **operands = &v->parents[1];
+        int num_operands = 1;
+        if (term->operation == '*') {
+            operands = term->parents;
+            num_operands = 2;
+        }
+        for (int i = 0; i < num_operands; i++) {
+            if (isParameter(operands[i])) continue;
+            fprintf(f, "v%d -> v%d;\n", operands[i]->id, head->id);
+            pushValue(stack, length, capacity, operands[i]);
+        }
+        terms++;
+
+        if (v->parents[0]->operation != '+') break;
+        v = v->parents[0];
+    }
+
+    // the start of the chain, usually a 0 leaf
+    BackpropValue *start = v->parents[0];
+    if (start->num_parents > 0) {
+        fprintf(f, "v%d -> v%d;\n", start->id, head->id);
+        pushValue(stack, length, capacity, start);
+    }
+
+    fprintf(f, "v%d [shape=box,label=\"id:%d\\nsum of %d\\nval:%.2f\\ngrad:%.2f\"];\n",
+            head->id, head->id, terms, head->value, head->grad);
+    return 0;
+}
+
+// Iterative depth first walk from output, every value is written once
+// when it leaves the stack, so the only memory used is the stack
+int exportGraph(FILE *f, BackpropValue *output, int format) {
+    graph_epoch += 2;
+    if (format == GRAPH_DOT_SUMMARY) {
+        markParameters();
+    }
+    int capacity = 1024;
+    int length = 0;
+    BackpropValue **stack = malloc(sizeof(BackpropValue*) * capacity);
+
+    pushValue(&stack, &length, &capacity, output);
+    while (length > 0) {
+        BackpropValue *v = stack[--length];
+
+        if (format == GRAPH_BINARY) {
+            writeBinaryValue(f, v);
+        } else if (format == GRAPH_DOT_SUMMARY && isChainHead(v)) {
+            writeChain(f, v, &stack, &length, &capacity);
+            continue;
+        } else {
+            fprintf(f, "v%d [label=\"id:%d\\nval:%.2f\\ngrad:%.2f\\nop:%c\"];\n",
+                    v->id, v->id, v->value, v->grad, v->operation);
+        }
+
+        for (int i = 0; i < v->num_parents; i++) {
+            if (format == GRAPH_DOT_SUMMARY && isParameter(v->parents[i])) continue;
+            if (format != GRAPH_BINARY) {
+                fprintf(f, "v%d -> v%d;\n", v->parents[i]->id, v->id);
+            }
+            pushValue(&stack, &length, &capacity, v->parents[i]);
+        }
+    }
+
+    free(stack);
+    return 0;
+}
+
+void writeGraphFile(BackpropValue *output, const char *filename, int format) {
+    FILE *f = fopen(filename, (format == GRAPH_BINARY) ? "wb" : "w");
     if (!f) {
         fprintf(stderr, "Could not open %s for writing.\n", filename);
         return;
     }
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
 
-    fprintf(f, "digraph G {\n");
-    int *visited = calloc(total_values, sizeof(int));
-    dumpGraphviz(f, output, visited, total_values);
-    free(visited);
-    fprintf(f, "}\n");
+    if (format == GRAPH_BINARY) {
+        fwrite("BPG1", 1, 4, f);
+    } else {
+        fprintf(f, "digraph G {\n");
+    }
+    exportGraph(f, output, format);
+    if (format != GRAPH_BINARY) {
+        fprintf(f, "}\n");
+    }
     fclose(f);
 }
 
+void writeDotFile(BackpropValue *output, const char *filename) {
+    writeGraphFile(output, filename, GRAPH_DOT);
+}
+
 int lossFunction(NN *nn) {
+    resetPools();
+
     BackpropValue **inputs = malloc(sizeof(BackpropValue*) * 3);
     for(int i = 0; i < 3; i++) {
         inputs[i] = malloc(sizeof(BackpropValue));
@@ -406,14 +724,17 @@ int lossFunction(NN *nn) {
     multiplyValues(act, loss_normalizer, loss); // Normalize the loss
     printf("Loss: %f\n", loss->value);
     // Backward pass
-    resetGrad(loss);
-    backwardValue(loss);
+    if (nn->checkpoint_every > 0) {
+        backwardCheckpointed(nn, loss);
+    } else {
+        resetGrad(loss);
+        backwardValue(loss);
+    }
     return 0;
 }
 
 int main() {
-    srand(91);
-    parameters = malloc(sizeof(BackpropValue*) * 1);
+    init_seed = 91;
 
     /*
     // EXAMPLE USAGE FOR BACKPROP VALUE
@@ -424,7 +745,7 @@ int main() {
     createValue(4.0f, bv2);
     createValue(0.0f, result); // Initialize result value
     addValues(bv1, bv2, result);
-    writeDotFile(result, "result.dot", 3);
+    writeDotFile(result, "result.dot");
     */
 
     /*
@@ -439,7 +760,7 @@ int main() {
     BackpropValue *output = malloc(sizeof(BackpropValue));
     createValue(0.0f, output); // Initialize output value
     callNeuron(neuron, inputs, output);
-    writeDotFile(output, "result.dot", 1024);
+    writeDotFile(output, "result.dot");
     */
 
     /*
@@ -461,6 +782,22 @@ int main() {
     }
     */
 
+    /*
+    // EXAMPLE USAGE FOR GRAPH EXPORT
+    NN *nn = malloc(sizeof(NN));
+    createNN(3, 2, 3, nn, 4);
+    BackpropValue **inputs = malloc(sizeof(BackpropValue*) * 3);
+    for(int i = 0; i < 3; i++) {
+        inputs[i] = malloc(sizeof(BackpropValue));
+        createValue((float)i, inputs[i]); // Initialize with some values
+    }
+    BackpropValue **outputs = malloc(sizeof(BackpropValue*) * 2);
+    callNN(nn, inputs, outputs);
+    writeDotFile(outputs[0], "result.dot");
+    writeGraphFile(outputs[0], "summary.dot", GRAPH_DOT_SUMMARY); // one node per neuron sum
+    writeGraphFile(outputs[0], "result.bin", GRAPH_BINARY);
+    */
+
     NN *nn = malloc(sizeof(NN));
     createNN(3, 2, 6, nn, 20); // Create a neural network with 3 layers, input size 3, output size 2, and hidden neurons size 4
     printf("%d parameters\n", parameters_length);
@@ -471,7 +808,34 @@ int main() {
         parameters[i]->value -= parameters[i]->grad * 0.01f; // Simple gradient descent step
     }
     lossFunction(nn); // Recalculate the loss after optimization
-    
+
+    // Same loss and gradients with gradient checkpointing, every 2 layers (~sqrt(n_layers))
+    float *grads = malloc(sizeof(float) * parameters_length);
+    backprop_pool_peak = 0;
+    lossFunction(nn);
+    printf("Peak values without checkpointing: %d\n", backprop_pool_peak);
+    for(int i = 0; i < parameters_length; i++) {
+        grads[i] = parameters[i]->grad;
+    }
+
+    nn->checkpoint_every = 2;
+    backprop_pool_peak = 0;
+    lossFunction(nn);
+    int checkpoint_values = 0;
+    for(int i = 1; i < nn->n_checkpoints; i++) {
+        checkpoint_values += nn->checkpoints[i].n;
+    }
+    printf("Peak values with checkpointing: %d (+%d checkpoints)\n", backprop_pool_peak, checkpoint_values);
+
+    float max_diff = 0.0f;
+    for(int i = 0; i < parameters_length; i++) {
+        float diff = fabsf(grads[i] - parameters[i]->grad);
+        if (diff > max_diff) max_diff = diff;
+    }
+    printf("Max gradient difference: %g\n", max_diff);
+    free(grads);
+    freeCheckpoints(nn);
+    nn->checkpoint_every = 0;
 
     return 0; 
 }
@@ -0,0 +1,142 @@
+#ifndef FIXED_NN_HPP
+#define FIXED_NN_HPP
+
+// Inference-only MLP whose shape is known at compile time, built from a
+// trained NN. Every loop bound is a template parameter and the activation
+// is chosen per layer at compile time, so the compiler can unroll and
+// vectorize the layers.
+//
+//   FixedNN<FixedLayer<784, 128, Activation::LeakyReLU>,
+//           FixedLayer<128, 10, Activation::Tanh>> fixed(nn);
+//   const TYPE* outputs = fixed(inputs);
+
+#include "MLP.h"
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+
+enum class Activation { LeakyReLU, Tanh };
+
+template <int Nin, int Nout, Activation A>
+struct FixedLayer {
+    static constexpr int nin = Nin;
+    static constexpr int nout = Nout;
+    static constexpr Activation activation = A;
+
+    // Stored input by input (weights[k * Nout + j] is weight k of neuron j),
+    // so the inner loop runs over the neurons and vectorizes without
+    // reordering the sums
+    alignas(64) std::array<TYPE, Nin * Nout> weights;
+    alignas(64) std::array<TYPE, Nout> bias;
+
+    static bool matches(const Layer& layer) {
+        return layer.num_neurons == Nout && layer.neurons[0].num_weights == Nin;
+    }
+
+    void load(const Layer& layer) {
+        for (int j = 0; j < Nout; j++) {
+            bias[j] = layer.neurons[j].bias;
+            for (int k = 0; k < Nin; k++) {
+                weights[k * Nout + j] = layer.neurons[j].weights[k];
+            }
+        }
+    }
+
+    void call(const TYPE* inputs, TYPE* outputs) const {
+        alignas(64) std::array<TYPE, Nout> sum = bias;
+        for (int k = 0; k < Nin; k++) {
+            const TYPE x = inputs[k];
+            const TYPE* w = &weights[k * Nout];
+            for (int j = 0; j < Nout; j++) {
+                sum[j] += w[j] * x;
+            }
+        }
+
+        for (int j = 0; j < Nout; j++) {
+            if constexpr (A == Activation::LeakyReLU) {
+                outputs[j] = (sum[j] > 0) ? sum[j] : 0.01 * sum[j];
+            } else {
+                outputs[j] = std::tanh(sum[j]);
+            }
+        }
+    }
+};
+
+// True if the nout of every layer is the nin of the next one
+template <typename... Layers>
+struct LayersChain {
+    static constexpr bool value = true;
+};
+
+template <typename First, typename Second, typename... Rest>
+struct LayersChain<First, Second, Rest...> {
+    static constexpr bool value = First::nout == Second::nin && LayersChain<Second, Rest...>::value;
+};
+
+// True if every layer but the last is LeakyReLU and the last one is Tanh,
+// the activations of callNN
+template <typename... Layers>
+struct LayersActivations {
+    static constexpr bool value = true;
+};
+
+template <typename Last>
+struct LayersActivations<Last> {
+    static constexpr bool value = Last::activation == Activation::Tanh;
+};
+
+template <typename First, typename Second, typename... Rest>
+struct LayersActivations<First, Second, Rest...> {
+    static constexpr bool value = First::activation == Activation::LeakyReLU && LayersActivations<Second, Rest...>::value;
+};
+
+template <typename... Layers>
+class FixedNN {
+    static_assert(LayersChain<Layers...>::value, "the nout of every layer must be the nin of the next one");
+    static_assert(LayersActivations<Layers...>::value, "hidden layers must be LeakyReLU and the output layer Tanh, like callNN");
+
+public:
+    static constexpr int num_layers = sizeof...(Layers);
+    static constexpr int nin = std::tuple_element_t<0, std::tuple<Layers...>>::nin;
+    static constexpr int nout = std::tuple_element_t<num_layers - 1, std::tuple<Layers...>>::nout;
+
+    // Throws std::invalid_argument if nn does not have this shape
+    explicit FixedNN(const NN* nn) {
+        if (!matches(nn, std::index_sequence_for<Layers...>{})) {
+            throw std::invalid_argument("NN shape does not match FixedNN");
+        }
+        load(nn, std::index_sequence_for<Layers...>{});
+    }
+
+    // The outputs stay valid until the next call
+    const TYPE* operator()(const TYPE* inputs) {
+        forward<0>(inputs);
+        return std::get<num_layers - 1>(values_).data();
+    }
+
+private:
+    template <std::size_t... I>
+    static bool matches(const NN* nn, std::index_sequence<I...>) {
+        return nn->num_layers == num_layers && (Layers::matches(nn->layers[I]) && ...);
+    }
+
+    template <std::size_t... I>
+    void load(const NN* nn, std::index_sequence<I...>) {
+        (std::get<I>(layers_).load(nn->layers[I]), ...);
+    }
+
+    template <std::size_t I>
+    void forward(const TYPE* inputs) {
+        std::get<I>(layers_).call(inputs, std::get<I>(values_).data());
+        if constexpr (I + 1 < num_layers) {
+            forward<I + 1>(std::get<I>(values_).data());
+        }
+    }
+
+    std::tuple<Layers...> layers_;
+    std::tuple<std::array<TYPE, Layers::nout>...> values_;
+};
+
+#endif
@@ -1,72 +1,176 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stdint.h>
 #include "MLP.h"
 
 #define TYPE double 
 
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"):
+// the 4 words are a pure function of the counter and the key
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+// Uniform in [-1, 1) with the 53 bits of a double
+TYPE uniform_from_bits(uint32_t high, uint32_t low) {
+    uint64_t bits = (((uint64_t)high << 32) | low) >> 11;
+    return (TYPE)bits * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+// Fill values[0..n) with scale * uniform(-1, 1), value i only depends on
+// (seed, stream, i), so the result does not depend on the number of threads
+void fill_uniform(TYPE* values, long n, uint64_t seed, uint32_t stream, TYPE scale) {
+    const uint32_t key[2] = {(uint32_t)seed, (uint32_t)(seed >> 32)};
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long p = 0; p < (n + 1) / 2; p++) {
+        const uint32_t counter[4] = {(uint32_t)p, (uint32_t)((uint64_t)p >> 32), stream, 0};
+        uint32_t r[4];
+        philox4x32(counter, key, r);
+
+        values[2 * p] = scale * uniform_from_bits(r[0], r[1]);
+        if (2 * p + 1 < n) {
+            values[2 * p + 1] = scale * uniform_from_bits(r[2], r[3]);
+        }
+    }
+}
+
+int init_parameters(NN* nn, uint64_t seed, int scheme) {
+    for (int i = 0; i < nn->num_layers; i++) {
+        Layer* l = &nn->layers[i];
+        int fan_in = l->neurons[0].num_weights;
+        int fan_out = l->num_neurons;
+
+        TYPE scale;
+        if (scheme == INIT_HE) {
+            scale = sqrt(6.0 / fan_in);
+        } else if (scheme == INIT_XAVIER) {
+            scale = sqrt(6.0 / (fan_in + fan_out));
+        } else if (i == nn->num_layers - 1) {
+            scale = sqrt(1.0 / (TYPE)fan_in); // tanh
+        } else {
+            scale = sqrt(2.0 / (TYPE)fan_in); // ReLU
+        }
+
+        // Weights of layer i are stream 2 * i, its biases stream 2 * i + 1
+        fill_uniform(l->neurons[0].weights, (long)fan_out * fan_in, seed, 2 * i, scale);
+
+        TYPE* biases = malloc(fan_out * sizeof(TYPE));
+        if (scheme == INIT_DEFAULT) {
+            fill_uniform(biases, fan_out, seed, 2 * i + 1, scale);
+        } else {
+            for (int j = 0; j < fan_out; j++) biases[j] = 0.0;
+        }
+        for (int j = 0; j < fan_out; j++) {
+            l->neurons[j].bias = biases[j];
+        }
+        free(biases);
+    }
+    return 0;
+}
+
 NN* createNN(int nin, int nout, int nlayers, int num_neurons) {
+    // The seed comes from rand() so that srand() still selects the network
+    return createNN_seeded(nin, nout, nlayers, num_neurons, (uint64_t)rand(), INIT_DEFAULT);
+}
+
+NN* createNN_seeded(int nin, int nout, int nlayers, int num_neurons, uint64_t seed, int scheme) {
     NN* nn = malloc(sizeof(NN));
 
     nn->num_layers = nlayers;
     nn->layers = malloc(nlayers * sizeof(Layer));
+    nn->loss = 0.0;
 
     for (int i = 0; i < nlayers; i++) {
         nn->layers[i].num_neurons = (i == nlayers - 1) ? nout : num_neurons; // Example: 10 neurons in hidden layers
+        nn->layers[i].sparse = NULL;
         nn->layers[i].neurons = malloc(nn->layers[i].num_neurons * sizeof(Neuron));
-        
-        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
-            int weights_size = (i == 0) ? nin : nn->layers[i - 1].num_neurons;
 
-            nn->layers[i].neurons[j].weights = malloc(weights_size * sizeof(TYPE));
+        // One block per layer for the weights and one for their gradients
+        int weights_size = (i == 0) ? nin : nn->layers[i - 1].num_neurons;
+        long layer_weights_size = (long)nn->layers[i].num_neurons * weights_size;
+        TYPE* layer_weights = malloc(layer_weights_size * sizeof(TYPE));
+        TYPE* layer_weights_grad = calloc(layer_weights_size, sizeof(TYPE));
 
-            TYPE random_bias = ((TYPE)rand() / (TYPE)RAND_MAX * (TYPE)2.0 - (TYPE)1.0); // Random bias between -1 and 1
-            if(i == nlayers - 1) {
-                // tanh
-                nn->layers[i].neurons[j].bias = random_bias * sqrt(1.0 / (TYPE)weights_size); // Scale bias for output layer
-            } else {
-                // ReLU
-                nn->layers[i].neurons[j].bias = random_bias * sqrt(2.0 / (TYPE)weights_size); // Scale bias for hidden layers
-            }
-
-            nn->layers[i].neurons[j].num_weights = weights_size;
-
-            nn->layers[i].neurons[j].value_grad = 0.0; // Initialize gradient for value
-            nn->layers[i].neurons[j].weights_grad = malloc(weights_size * sizeof(TYPE)); // Initialize gradient for weights
-            nn->layers[i].neurons[j].bias_grad = 0.0; // Initialize gradient for bias
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
+            Neuron* neuron = &nn->layers[i].neurons[j];
+            neuron->weights = &layer_weights[(long)j * weights_size];
+            neuron->num_weights = weights_size;
+            neuron->value_grad = 0.0; // Initialize gradient for value
+            neuron->weights_grad = &layer_weights_grad[(long)j * weights_size];
+            neuron->bias_grad = 0.0; // Initialize gradient for bias
+            neuron->mask = NULL;
+        }
+    }
 
-            for (int k = 0; k < weights_size; k++) {
-                TYPE random_weight = ((TYPE)rand() / (TYPE)RAND_MAX * (TYPE)2.0 - (TYPE)1.0); // Random weight between -1 and 1
-                if (i == nlayers - 1) {
-                    // tanh
-                    nn->layers[i].neurons[j].weights[k] = random_weight * sqrt(1.0 / (TYPE)weights_size); // Scale weights for output layer
-                } else {
-                    // ReLU
-                    nn->layers[i].neurons[j].weights[k] = random_weight * sqrt(2.0 / (TYPE)weights_size); // Scale weights for hidden layers
-                }
+    init_parameters(nn, seed, scheme);
+    return nn;
+}
 
-                nn->layers[i].neurons[j].weights_grad[k] = 0.0; // Initialize weight gradient
-            }
+void freeNN(NN* nn) {
+    free_sparse_layers(nn);
+    for (int i = 0; i < nn->num_layers; i++) {
+        free(nn->layers[i].neurons[0].weights);
+        free(nn->layers[i].neurons[0].weights_grad);
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
+            free(nn->layers[i].neurons[j].mask);
         }
+        free(nn->layers[i].neurons);
     }
-    return nn;
+    free(nn->layers);
+    free(nn);
 }
 
 TYPE* callNN(NN* nn, TYPE* inputs) {
     nn->inputs = inputs;
 
     for (int i = 0; i < nn->num_layers; i++) {
+        SparseWeights* sparse = nn->layers[i].sparse;
+
         for (int j = 0; j < nn->layers[i].num_neurons; j++) {
             Neuron* neuron = &nn->layers[i].neurons[j];
             neuron->value = neuron->bias; // Start with bias
 
-            for (int k = 0; k < neuron->num_weights; k++) {
-                if (i == 0) {
-                    // Input layer
-                    neuron->value += inputs[k] * neuron->weights[k];
-                } else {
-                    // Hidden and output layers
-                    neuron->value += nn->layers[i - 1].neurons[k].value * neuron->weights[k];
+            if (sparse != NULL) {
+                for (int k = sparse->row_start[j]; k < sparse->row_start[j + 1]; k++) {
+                    int column = sparse->columns[k];
+                    if (i == 0) {
+                        neuron->value += inputs[column] * sparse->values[k];
+                    } else {
+                        neuron->value += nn->layers[i - 1].neurons[column].value * sparse->values[k];
+                    }
+                }
+            } else {
+                for (int k = 0; k < neuron->num_weights; k++) {
+                    if (i == 0) {
+                        // Input layer
+                        neuron->value += inputs[k] * neuron->weights[k];
+                    } else {
+                        // Hidden and output layers
+                        neuron->value += nn->layers[i - 1].neurons[k].value * neuron->weights[k];
+                    }
                 }
             }
 
@@ -119,6 +223,7 @@ int reset_grad(NN* nn) {
 }
 
 int calculate_grad(NN* nn, TYPE* inputs[], TYPE* outputs[], int samples_count) {
+    nn->loss = 0.0;
     for (int j = 0; j < samples_count; j++) {
         TYPE* output = callNN(nn, inputs[j]);
 
@@ -129,7 +234,7 @@ int calculate_grad(NN* nn, TYPE* inputs[], TYPE* outputs[], int samples_count) {
                 if (k == nn->num_layers - 1) {
                     // Output layer: each neuron only for its own output!
                     TYPE error = outputs[j][l] - output[l];
-                    TYPE loss = error * error;
+                    nn->loss += error * error;
                     TYPE derivative = -2.0 * error;
                     neuron->value_grad = derivative * (1.0 - output[l] * output[l]);
                 } else {
@@ -152,18 +257,22 @@ int calculate_grad(NN* nn, TYPE* inputs[], TYPE* outputs[], int samples_count) {
                 }
             }
         }
+        free(output);
     }
 
     return 0;
 }
 
 int optimise_parameters(NN* nn, TYPE learning_rate, int sample_size) {
+    free_sparse_layers(nn); // the CSR copies would be out of date
+
     for (int l = 0; l < nn->num_layers; l++) {
         for (int m = 0; m < nn->layers[l].num_neurons; m++) {
             Neuron* neuron = &nn->layers[l].neurons[m];
             neuron->bias -= learning_rate * neuron->bias_grad / sample_size; // Update bias
 
             for (int k = 0; k < neuron->num_weights; k++) {
+                if (neuron->mask != NULL && !neuron->mask[k]) continue; // Pruned weights stay at 0
                 neuron->weights[k] -= learning_rate * neuron->weights_grad[k] / sample_size; // Update weights
             }
         }
@@ -172,3 +281,294 @@ int optimise_parameters(NN* nn, TYPE learning_rate, int sample_size) {
     return 0;
 }
 
+// L2 norm of the gradient of every parameter
+TYPE grad_norm(NN* nn) {
+    TYPE sum = 0.0;
+    for (int l = 0; l < nn->num_layers; l++) {
+        long n = (long)nn->layers[l].num_neurons * nn->layers[l].neurons[0].num_weights;
+        TYPE* weights_grad = nn->layers[l].neurons[0].weights_grad;
+        for (long k = 0; k < n; k++) {
+            sum += weights_grad[k] * weights_grad[k];
+        }
+        for (int m = 0; m < nn->layers[l].num_neurons; m++) {
+            sum += nn->layers[l].neurons[m].bias_grad * nn->layers[l].neurons[m].bias_grad;
+        }
+    }
+    return sqrt(sum);
+}
+
+int compare_magnitudes(const void* a, const void* b) {
+    TYPE x = *(const TYPE*)a;
+    TYPE y = *(const TYPE*)b;
+    return (x > y) - (x < y);
+}
+
+// Zero the smallest weights (in magnitude) of a layer until sparsity of them
+// are 0. Pruned weights are masked, so they stay at 0 when fine-tuning with
+// calculate_grad and optimise_parameters. Sparsity can be raised step by step,
+// it must be in [0, 1], otherwise nothing is pruned and -1 is returned.
+int prune_layer(NN* nn, int layer, TYPE sparsity) {
+    if (!(sparsity >= 0.0 && sparsity <= 1.0)) {
+        printf("Sparsity %f is not in [0, 1]\n", sparsity);
+        return -1;
+    }
+    Layer* l = &nn->layers[layer];
+    int total = l->num_neurons * l->neurons[0].num_weights;
+    int to_prune = (int)(sparsity * total);
+    if (to_prune <= 0) return 0;
+
+    TYPE* magnitudes = malloc(total * sizeof(TYPE));
+    for (int j = 0; j < l->num_neurons; j++) {
+        for (int k = 0; k < l->neurons[j].num_weights; k++) {
+            magnitudes[j * l->neurons[j].num_weights + k] = fabs(l->neurons[j].weights[k]);
+        }
+    }
+    qsort(magnitudes, total, sizeof(TYPE), compare_magnitudes);
+    TYPE threshold = magnitudes[to_prune - 1];
+    free(magnitudes);
+
+    int pruned = 0;
+    for (int j = 0; j < l->num_neurons; j++) {
+        Neuron* neuron = &l->neurons[j];
+        if (neuron->mask == NULL) {
+            neuron->mask = malloc(neuron->num_weights * sizeof(unsigned char));
+            for (int k = 0; k < neuron->num_weights; k++) neuron->mask[k] = 1;
+        }
+        for (int k = 0; k < neuron->num_weights; k++) {
+            if (pruned < to_prune && fabs(neuron->weights[k]) <= threshold) {
+                neuron->weights[k] = 0.0;
+                neuron->mask[k] = 0;
+                pruned++;
+            }
+        }
+    }
+
+    return pruned;
+}
+
+TYPE layer_density(NN* nn, int layer) {
+    Layer* l = &nn->layers[layer];
+    int non_zero = 0, total = 0;
+    for (int j = 0; j < l->num_neurons; j++) {
+        for (int k = 0; k < l->neurons[j].num_weights; k++) {
+            non_zero += l->neurons[j].weights[k] != 0.0;
+        }
+        total += l->neurons[j].num_weights;
+    }
+    return (TYPE)non_zero / (TYPE)total;
+}
+
+// Build the CSR weights of every layer sparse enough for them to be faster.
+// Must be called again after training, optimise_parameters drops them.
+int use_sparse_layers(NN* nn) {
+    free_sparse_layers(nn);
+
+    int sparse_layers = 0;
+    for (int i = 0; i < nn->num_layers; i++) {
+        if (layer_density(nn, i) > SPARSE_MAX_DENSITY) continue;
+
+        Layer* l = &nn->layers[i];
+        int non_zero = 0;
+        for (int j = 0; j < l->num_neurons; j++) {
+            for (int k = 0; k < l->neurons[j].num_weights; k++) {
+                non_zero += l->neurons[j].weights[k] != 0.0;
+            }
+        }
+
+        SparseWeights* sparse = malloc(sizeof(SparseWeights));
+        sparse->num_rows = l->num_neurons;
+        sparse->row_start = malloc((l->num_neurons + 1) * sizeof(int));
+        sparse->columns = malloc(non_zero * sizeof(int));
+        sparse->values = malloc(non_zero * sizeof(TYPE));
+
+        int n = 0;
+        for (int j = 0; j < l->num_neurons; j++) {
+            sparse->row_start[j] = n;
+            for (int k = 0; k < l->neurons[j].num_weights; k++) {
+                if (l->neurons[j].weights[k] != 0.0) {
+                    sparse->columns[n] = k;
+                    sparse->values[n] = l->neurons[j].weights[k];
+                    n++;
+                }
+            }
+        }
+        sparse->row_start[l->num_neurons] = n;
+
+        l->sparse = sparse;
+        sparse_layers++;
+    }
+
+    return sparse_layers;
+}
+
+int free_sparse_layers(NN* nn) {
+    for (int i = 0; i < nn->num_layers; i++) {
+        SparseWeights* sparse = nn->layers[i].sparse;
+        if (sparse == NULL) continue;
+        free(sparse->row_start);
+        free(sparse->columns);
+        free(sparse->values);
+        free(sparse);
+        nn->layers[i].sparse = NULL;
+    }
+    return 0;
+}
+
+// Inference on a whole batch, layer by layer. Activations are stored feature
+// by feature (activations[k * samples_count + s]) so that the inner loop over
+// the samples is contiguous for both the dense and the CSR kernels.
+// Writes the outputs of sample s at outputs[s * nout], the neuron values are
+// not changed. The feature-major activations are internal copies.
+int callNN_batch_into(NN* nn, TYPE* inputs[], int samples_count, TYPE* outputs) {
+    int nin = nn->layers[0].neurons[0].num_weights;
+    TYPE* activations = malloc(nin * samples_count * sizeof(TYPE));
+    for (int s = 0; s < samples_count; s++) {
+        for (int k = 0; k < nin; k++) {
+            activations[k * samples_count + s] = inputs[s][k];
+        }
+    }
+
+    for (int i = 0; i < nn->num_layers; i++) {
+        Layer* l = &nn->layers[i];
+        TYPE* next = malloc(l->num_neurons * samples_count * sizeof(TYPE));
+
+        for (int j = 0; j < l->num_neurons; j++) {
+            Neuron* neuron = &l->neurons[j];
+            TYPE* out = &next[j * samples_count];
+            for (int s = 0; s < samples_count; s++) out[s] = neuron->bias;
+
+            if (l->sparse != NULL) {
+                for (int k = l->sparse->row_start[j]; k < l->sparse->row_start[j + 1]; k++) {
+                    TYPE w = l->sparse->values[k];
+                    TYPE* in = &activations[l->sparse->columns[k] * samples_count];
+                    for (int s = 0; s < samples_count; s++) out[s] += w * in[s];
+                }
+            } else {
+                for (int k = 0; k < neuron->num_weights; k++) {
+                    TYPE w = neuron->weights[k];
+                    TYPE* in = &activations[k * samples_count];
+                    for (int s = 0; s < samples_count; s++) out[s] += w * in[s];
+                }
+            }
+
+            for (int s = 0; s < samples_count; s++) {
+                if (i < nn->num_layers - 1) {
+                    out[s] = (out[s] > 0) ? out[s] : 0.01 * out[s]; // Leaky ReLU
+                } else {
+                    out[s] = tanh(out[s]);
+                }
+            }
+        }
+
+        free(activations);
+        activations = next;
+    }
+
+    int nout = nn->layers[nn->num_layers - 1].num_neurons;
+    for (int s = 0; s < samples_count; s++) {
+        for (int j = 0; j < nout; j++) {
+            outputs[s * nout + j] = activations[j * samples_count + s];
+        }
+    }
+    free(activations);
+    return 0;
+}
+
+// Same as callNN_batch_into, returns a new samples_count x nout array
+TYPE* callNN_batch(NN* nn, TYPE* inputs[], int samples_count) {
+    int nout = nn->layers[nn->num_layers - 1].num_neurons;
+    TYPE* outputs = malloc(nout * samples_count * sizeof(TYPE));
+    callNN_batch_into(nn, inputs, samples_count, outputs);
+    return outputs;
+}
+
+// Binary file: "MLP1", num_layers, nin, the number of neurons of every
+// layer, then the weights and the bias of every neuron
+int save_nn(NN* nn, const char* filename) {
+    FILE* fp = fopen(filename, "wb");
+    if (!fp) {
+        printf("Cannot open %s\n", filename);
+        return -1;
+    }
+
+    int nin = nn->layers[0].neurons[0].num_weights;
+    fwrite("MLP1", 1, 4, fp);
+    fwrite(&nn->num_layers, sizeof(int), 1, fp);
+    fwrite(&nin, sizeof(int), 1, fp);
+    for (int i = 0; i < nn->num_layers; i++) {
+        fwrite(&nn->layers[i].num_neurons, sizeof(int), 1, fp);
+    }
+    for (int i = 0; i < nn->num_layers; i++) {
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
+            fwrite(nn->layers[i].neurons[j].weights, sizeof(TYPE), nn->layers[i].neurons[j].num_weights, fp);
+            fwrite(&nn->layers[i].neurons[j].bias, sizeof(TYPE), 1, fp);
+        }
+    }
+
+    int failed = ferror(fp);
+    fclose(fp);
+    return failed ? -1 : 0;
+}
+
+// Largest number of layers, inputs or neurons in a layer that load_nn accepts
+#define MLP_FILE_MAX_SIZE (1 << 20)
+
+// The header is checked before anything is allocated: every size must be in
+// [1, MLP_FILE_MAX_SIZE] and the file must be long enough for the parameters
+NN* load_nn(const char* filename) {
+    FILE* fp = fopen(filename, "rb");
+    if (!fp) {
+        printf("Cannot open %s\n", filename);
+        return NULL;
+    }
+
+    char magic[4];
+    int num_layers, nin;
+    if (fread(magic, 1, 4, fp) != 4 || magic[0] != 'M' || magic[1] != 'L' || magic[2] != 'P' || magic[3] != '1'
+        || fread(&num_layers, sizeof(int), 1, fp) != 1 || fread(&nin, sizeof(int), 1, fp) != 1
+        || num_layers < 1 || num_layers > MLP_FILE_MAX_SIZE || nin < 1 || nin > MLP_FILE_MAX_SIZE) {
+        printf("Invalid MLP file!\n");
+        fclose(fp);
+        return NULL;
+    }
+
+    // createNN only supports the same number of neurons in every hidden layer
+    int* num_neurons = malloc(num_layers * sizeof(int));
+    int valid = fread(num_neurons, sizeof(int), num_layers, fp) == (size_t)num_layers;
+    long num_parameters = 0;
+    for (int i = 0; valid && i < num_layers; i++) {
+        valid = num_neurons[i] >= 1 && num_neurons[i] <= MLP_FILE_MAX_SIZE
+            && (i == 0 || i == num_layers - 1 || num_neurons[i] == num_neurons[0]);
+        num_parameters += (long)num_neurons[i] * (((i == 0) ? nin : num_neurons[i - 1]) + 1);
+    }
+    if (valid) {
+        long header_end = ftell(fp);
+        fseek(fp, 0, SEEK_END);
+        valid = ftell(fp) - header_end >= num_parameters * (long)sizeof(TYPE);
+        fseek(fp, header_end, SEEK_SET);
+    }
+    if (!valid) {
+        printf("Invalid MLP file!\n");
+        free(num_neurons);
+        fclose(fp);
+        return NULL;
+    }
+
+    NN* nn = createNN(nin, num_neurons[num_layers - 1], num_layers, num_neurons[0]);
+    free(num_neurons);
+    for (int i = 0; valid && i < nn->num_layers; i++) {
+        for (int j = 0; valid && j < nn->layers[i].num_neurons; j++) {
+            Neuron* neuron = &nn->layers[i].neurons[j];
+            valid = fread(neuron->weights, sizeof(TYPE), neuron->num_weights, fp) == (size_t)neuron->num_weights
+                && fread(&neuron->bias, sizeof(TYPE), 1, fp) == 1;
+        }
+    }
+    fclose(fp);
+
+    if (!valid) {
+        printf("Invalid MLP file!\n");
+        freeNN(nn);
+        return NULL;
+    }
+    return nn;
+}
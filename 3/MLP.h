@@ -1,8 +1,14 @@
 #ifndef MLP_H 
 #define MLP_H 
 
+#include <stdint.h>
+
 #define TYPE double 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct Neuron {
     TYPE* weights;
     int num_weights;
@@ -12,24 +18,51 @@ typedef struct Neuron {
     TYPE value_grad; // NOT MEMORY EFFICIENT
     TYPE* weights_grad; // NOT MEMORY EFFICIENT
     TYPE bias_grad; // NOT MEMORY EFFICIENT
+
+    unsigned char* mask; // 0 for pruned weights, NULL if the neuron was never pruned
 } Neuron;
 
+// CSR copy of the weights of a layer, row i is neuron i
+typedef struct SparseWeights {
+    int num_rows;
+    int* row_start; // num_rows + 1 entries
+    int* columns;
+    TYPE* values;
+} SparseWeights;
+
+// The weights (and weights_grad) of the neurons of a layer are one
+// num_neurons x num_weights block starting at neurons[0].weights
 typedef struct Layer {
     int num_neurons;
     Neuron* neurons;
+    SparseWeights* sparse; // used by callNN instead of the weights when not NULL
 } Layer;
 
 typedef struct NN {
     int num_layers;
     Layer* layers;
     TYPE *inputs;
+    TYPE loss; // sum of the squared errors of the last calculate_grad
     // to access inputs size, we can use nn->layers[0].neurons[0].num_weights
     // to access outputs, we can use nn->layers[nn->num_layers - 1].neurons[i].value where i is for i = 0 to i < nn->layers[nn->num_layers - 1].num_neurons
 } NN;
 
 
+// Weight initialisation schemes, every parameter is a pure function of
+// (seed, layer, index) so the initialisation runs in parallel (OpenMP) and
+// gives the same network for any number of threads
+#define INIT_DEFAULT 0 // uniform * sqrt(2 / fan_in), sqrt(1 / fan_in) for the tanh output layer
+#define INIT_HE 1 // He uniform, biases at 0
+#define INIT_XAVIER 2 // Xavier (Glorot) uniform, biases at 0
+
 NN* createNN(int nin, int nout, int nlayers, int num_neurons);
 
+NN* createNN_seeded(int nin, int nout, int nlayers, int num_neurons, uint64_t seed, int scheme);
+
+int init_parameters(NN* nn, uint64_t seed, int scheme);
+
+void freeNN(NN* nn);
+
 TYPE* callNN(NN* nn, TYPE* inputs);
 
 int reset_grad(NN* nn);
@@ -38,7 +71,34 @@ int calculate_grad(NN* nn, TYPE* inputs[], TYPE* outputs[], int samples_count);
 
 int optimise_parameters(NN* nn, TYPE learning_rate, int sample_size);
 
+TYPE grad_norm(NN* nn);
+
 void visualiseNN(NN* nn);
 
+int save_nn(NN* nn, const char* filename);
+
+NN* load_nn(const char* filename);
+
+// Pruning and sparse inference
+
+// Layers with a lower density than this are run with the CSR kernels
+#define SPARSE_MAX_DENSITY 0.3
+
+int prune_layer(NN* nn, int layer, TYPE sparsity);
+
+TYPE layer_density(NN* nn, int layer);
+
+int use_sparse_layers(NN* nn);
+
+int free_sparse_layers(NN* nn);
+
+int callNN_batch_into(NN* nn, TYPE* inputs[], int samples_count, TYPE* outputs);
+
+TYPE* callNN_batch(NN* nn, TYPE* inputs[], int samples_count);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif 
 
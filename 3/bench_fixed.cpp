@@ -0,0 +1,67 @@
+// Latency of the generic callNN against FixedNN for the production shape
+// 784-128-128-128-10, on the same random weights and inputs. Both sides must
+// be built with the same flags for the comparison to be fair.
+//
+// gcc -O3 -march=native -c MLP.c && g++ -O3 -march=native -std=c++17 bench_fixed.cpp MLP.o -o bench_fixed
+
+#include "FixedNN.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#define NUM_SAMPLES 1000
+#define RUNS 20
+
+using ProductionNN = FixedNN<FixedLayer<784, 128, Activation::LeakyReLU>,
+                             FixedLayer<128, 128, Activation::LeakyReLU>,
+                             FixedLayer<128, 128, Activation::LeakyReLU>,
+                             FixedLayer<128, 10, Activation::Tanh>>;
+
+double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main() {
+    srand(42);
+    NN* nn = createNN(784, 10, 4, 128);
+
+    std::vector<std::vector<TYPE>> inputs(NUM_SAMPLES, std::vector<TYPE>(784));
+    for (auto& input : inputs) {
+        for (auto& x : input) x = (TYPE)rand() / (TYPE)RAND_MAX;
+    }
+
+    // ~1 MB of weights, too much for the stack
+    auto fixed = std::make_unique<ProductionNN>(nn);
+
+    TYPE max_diff = 0.0;
+    for (auto& input : inputs) {
+        TYPE* generic = callNN(nn, input.data());
+        const TYPE* specialized = (*fixed)(input.data());
+        for (int k = 0; k < ProductionNN::nout; k++) {
+            max_diff = std::fmax(max_diff, std::fabs(generic[k] - specialized[k]));
+        }
+        free(generic);
+    }
+
+    double start = now();
+    for (int r = 0; r < RUNS; r++) {
+        for (auto& input : inputs) free(callNN(nn, input.data()));
+    }
+    double generic_time = (now() - start) * 1e6 / (RUNS * NUM_SAMPLES);
+
+    TYPE checksum = 0.0;
+    start = now();
+    for (int r = 0; r < RUNS; r++) {
+        for (auto& input : inputs) checksum += (*fixed)(input.data())[0];
+    }
+    double fixed_time = (now() - start) * 1e6 / (RUNS * NUM_SAMPLES);
+
+    printf("Max output difference: %e (checksum %f)\n", max_diff, checksum);
+    printf("callNN:  %8.2f us/sample\n", generic_time);
+    printf("FixedNN: %8.2f us/sample (%.1fx)\n", fixed_time, generic_time / fixed_time);
+    return 0;
+}
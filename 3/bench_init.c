@@ -0,0 +1,79 @@
+// Startup time of createNN for multi-million parameter networks: the
+// counter-based initialisation with 1..max OpenMP threads, against the
+// previous one (serial rand(), two mallocs per neuron). The checksum must be
+// the same for every number of threads.
+//
+// gcc -O2 -fopenmp bench_init.c MLP.c timer.c -lm -o bench_init
+
+#include "MLP.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define TYPE double
+#define NIN 784
+#define NOUT 10
+#define NLAYERS 4
+
+// Initialisation of createNN before the counter-based one
+double legacy_init(int num_neurons) {
+    double start = now();
+    for (int i = 0; i < NLAYERS; i++) {
+        int neurons = (i == NLAYERS - 1) ? NOUT : num_neurons;
+        int weights_size = (i == 0) ? NIN : num_neurons;
+        TYPE scale = sqrt(((i == NLAYERS - 1) ? 1.0 : 2.0) / weights_size);
+        for (int j = 0; j < neurons; j++) {
+            TYPE* weights = malloc(weights_size * sizeof(TYPE));
+            TYPE* weights_grad = malloc(weights_size * sizeof(TYPE));
+            for (int k = 0; k < weights_size; k++) {
+                weights[k] = ((TYPE)rand() / (TYPE)RAND_MAX * 2.0 - 1.0) * scale;
+                weights_grad[k] = 0.0;
+            }
+            free(weights);
+            free(weights_grad);
+        }
+    }
+    return now() - start;
+}
+
+TYPE checksum(NN* nn) {
+    TYPE sum = 0.0;
+    for (int i = 0; i < nn->num_layers; i++) {
+        long n = (long)nn->layers[i].num_neurons * nn->layers[i].neurons[0].num_weights;
+        for (long k = 0; k < n; k++) sum += nn->layers[i].neurons[0].weights[k] * (k % 7 + 1);
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) sum += nn->layers[i].neurons[j].bias;
+    }
+    return sum;
+}
+
+int main() {
+    int max_threads = 1;
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+    int sizes[] = {512, 1024, 2048};
+
+    for (int s = 0; s < 3; s++) {
+        int num_neurons = sizes[s];
+        long parameters = (long)(NIN + 1) * num_neurons + (long)(num_neurons + 1) * num_neurons * (NLAYERS - 2)
+                        + (long)(num_neurons + 1) * NOUT;
+        printf("%ld parameters\n", parameters);
+        printf("  legacy rand():    %8.1f ms\n", legacy_init(num_neurons) * 1e3);
+
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+#ifdef _OPENMP
+            omp_set_num_threads(threads);
+#endif
+            double start = now();
+            NN* nn = createNN_seeded(NIN, NOUT, NLAYERS, num_neurons, 42, INIT_HE);
+            double elapsed = now() - start;
+            printf("  %2d thread(s):     %8.1f ms, checksum %.17g\n", threads, elapsed * 1e3, checksum(nn));
+            freeNN(nn);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Accuracy and inference latency of the MNIST MLP after magnitude pruning of
+// the hidden layers to 50/80/90% sparsity, with a fine-tuning cycle after
+// every pruning step (iterative pruning).
+//
+// gcc -O2 bench_prune.c MLP.c mnist.c timer.c -lm -o bench_prune
+
+#include "MLP.h"
+#include "mnist.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TYPE double
+#define LEARNING_RATE 1e-3
+
+#define TRAINING_CYCLES 10
+#define FINE_TUNING_CYCLES 2
+#define TRAINING_IMAGES 6000
+#define BATCH_SIZE 32
+#define LATENCY_RUNS 5
+
+// Same encoding as main.c: pixels in [0, 1], one-hot outputs in {-1, 1}
+TYPE** load_inputs(const char* filename, int* num_images, int* nin) {
+    int rows, cols;
+    unsigned char* images = read_mnist_images(filename, num_images, &rows, &cols);
+    if (images == NULL) return NULL;
+
+    *nin = rows * cols;
+    TYPE** inputs = malloc(*num_images * sizeof(TYPE*));
+    for (int i = 0; i < *num_images; i++) {
+        inputs[i] = malloc(*nin * sizeof(TYPE));
+        for (int j = 0; j < *nin; j++) {
+            inputs[i][j] = (TYPE)images[i * (*nin) + j] / 255.0;
+        }
+    }
+    free(images);
+    return inputs;
+}
+
+TYPE** load_outputs(unsigned char* labels, int num_labels) {
+    TYPE** outputs = malloc(num_labels * sizeof(TYPE*));
+    for (int i = 0; i < num_labels; i++) {
+        outputs[i] = malloc(10 * sizeof(TYPE));
+        for (int j = 0; j < 10; j++) {
+            outputs[i][j] = (j == labels[i]) ? 1.0 : -1.0;
+        }
+    }
+    return outputs;
+}
+
+void train(NN* nn, TYPE** inputs, TYPE** outputs, int cycles) {
+    for (int i = 0; i < cycles; i++) {
+        for (int j = 0; j < TRAINING_IMAGES; j += BATCH_SIZE) {
+            int batch_size = (j + BATCH_SIZE > TRAINING_IMAGES) ? TRAINING_IMAGES - j : BATCH_SIZE;
+            reset_grad(nn);
+            calculate_grad(nn, &inputs[j], &outputs[j], batch_size);
+            optimise_parameters(nn, LEARNING_RATE, batch_size);
+        }
+    }
+}
+
+TYPE accuracy(NN* nn, TYPE** inputs, unsigned char* labels, int num_images) {
+    TYPE* outputs = callNN_batch(nn, inputs, num_images);
+    int correct = 0;
+    for (int i = 0; i < num_images; i++) {
+        int best = 0;
+        for (int k = 1; k < 10; k++) {
+            if (outputs[i * 10 + k] > outputs[i * 10 + best]) best = k;
+        }
+        correct += best == labels[i];
+    }
+    free(outputs);
+    return (TYPE)correct / num_images;
+}
+
+// Microseconds per sample, one sample at a time with callNN and all at once with callNN_batch
+void latency(NN* nn, TYPE** inputs, int num_images, double* single, double* batch) {
+    double start = now();
+    for (int r = 0; r < LATENCY_RUNS; r++) {
+        for (int i = 0; i < num_images; i++) {
+            free(callNN(nn, inputs[i]));
+        }
+    }
+    *single = (now() - start) * 1e6 / (LATENCY_RUNS * num_images);
+
+    start = now();
+    for (int r = 0; r < LATENCY_RUNS; r++) {
+        free(callNN_batch(nn, inputs, num_images));
+    }
+    *batch = (now() - start) * 1e6 / (LATENCY_RUNS * num_images);
+}
+
+void report(NN* nn, TYPE sparsity, TYPE** test_inputs, unsigned char* test_labels, int num_test) {
+    double dense_single, dense_batch, sparse_single, sparse_batch;
+
+    free_sparse_layers(nn);
+    latency(nn, test_inputs, num_test, &dense_single, &dense_batch);
+    int sparse_layers = use_sparse_layers(nn);
+    latency(nn, test_inputs, num_test, &sparse_single, &sparse_batch);
+
+    printf("%3.0f%% | %6.2f%% | %6.1f us %6.1f us | %6.1f us %6.1f us | %d sparse layers\n",
+           sparsity * 100, accuracy(nn, test_inputs, test_labels, num_test) * 100,
+           dense_single, dense_batch, sparse_single, sparse_batch, sparse_layers);
+}
+
+int main() {
+    int num_images, num_labels, num_test, num_test_labels, nin;
+    TYPE** inputs = load_inputs("data/train-images.idx3-ubyte", &num_images, &nin);
+    unsigned char* labels = read_mnist_labels("data/train-labels.idx1-ubyte", &num_labels);
+    TYPE** test_inputs = load_inputs("data/t10k-images.idx3-ubyte", &num_test, &nin);
+    unsigned char* test_labels = read_mnist_labels("data/t10k-labels.idx1-ubyte", &num_test_labels);
+    if (inputs == NULL || labels == NULL || test_inputs == NULL || test_labels == NULL) {
+        return 1;
+    }
+    TYPE** outputs = load_outputs(labels, num_labels);
+
+    srand(42);
+    NN* nn = createNN(nin, 10, 4, 128);
+    train(nn, inputs, outputs, TRAINING_CYCLES);
+
+    printf("sparsity | accuracy | dense (callNN, batch) | sparse (callNN, batch)\n");
+    report(nn, 0.0, test_inputs, test_labels, num_test);
+
+    TYPE sparsities[] = {0.5, 0.8, 0.9};
+    for (int s = 0; s < 3; s++) {
+        // the output layer is kept dense
+        for (int i = 0; i < nn->num_layers - 1; i++) {
+            prune_layer(nn, i, sparsities[s]);
+        }
+        train(nn, inputs, outputs, FINE_TUNING_CYCLES);
+        report(nn, sparsities[s], test_inputs, test_labels, num_test);
+    }
+
+    return 0;
+}
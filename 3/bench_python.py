@@ -0,0 +1,50 @@
+# Training speed of the native MLP through mlp.py against the Value MLP of
+# 1/main.py, on the toy problem of 1/main.py (3 inputs, 10 hidden layers of
+# 10 neurons, 1 output). The activations differ (softplus/tanh in 1/, leaky
+# ReLU/tanh here), the sizes and the work per step are the same.
+#
+# gcc -O2 -shared -fPIC mlp_capi.c MLP.c -lm -o libmlp.so && python3 bench_python.py
+
+import array
+import os
+import sys
+import time
+
+import mlp
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "1"))
+import main as reference
+
+PYTHON_STEPS = 50
+NATIVE_STEPS = 1000
+
+# 1/main.py
+net = reference.MLP(nin=3, nout=1, nhidden=10, nhin=10)
+input_data = [reference.Value(1.0), reference.Value(2.0), reference.Value(3.0)]
+expected_output = [reference.Value(0.5)]
+start = time.perf_counter()
+for _ in range(PYTHON_STEPS):
+    net.reset_grads()
+    loss = reference.Value(0.0)
+    for o, e in zip(net(input_data), expected_output):
+        loss = loss + (o - e) ** reference.Value(2.0)
+    loss.backward()
+    for layer in net.layers:
+        for neuron in layer.neurons:
+            for w in neuron.w:
+                w.value -= 0.01 * w.grad
+            neuron.b.value -= 0.01 * neuron.b.grad
+python_time = (time.perf_counter() - start) / PYTHON_STEPS
+
+# Native, same loop from Python
+native = mlp.MLP(nin=3, nout=1, nlayers=12, num_neurons=10)
+inputs = array.array("d", [1.0, 2.0, 3.0])
+targets = array.array("d", [0.5])
+start = time.perf_counter()
+for _ in range(NATIVE_STEPS):
+    native_loss = native.train_on_batch(inputs, targets, 0.01)
+native_time = (time.perf_counter() - start) / NATIVE_STEPS
+
+print(f"1/main.py: {python_time * 1e6:10.1f} us/step (loss {loss.value:f})")
+print(f"mlp.py:    {native_time * 1e6:10.1f} us/step (loss {native_loss:f})")
+print(f"speedup:   {python_time / native_time:10.1f}x")
@@ -0,0 +1,70 @@
+// Training throughput of the MNIST-sized MLP (784-128-128-128-10, batches of
+// 32) with a snapshot every N batches, background (snapshot_take) against
+// writing and fsyncing the weights from the training thread (save_nn).
+// Uses random data.
+//
+// gcc -O2 bench_snapshot.c MLP.c snapshot.c timer.c samples.c -lm -lpthread -o bench_snapshot
+
+#include "MLP.h"
+#include "snapshot.h"
+#include "timer.h"
+#include "samples.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define TYPE double
+#define LEARNING_RATE 1e-3
+#define BATCH_SIZE 32
+#define NUM_BATCHES 300
+#define SNAPSHOT_FILE "bench.snp"
+
+// mode 0: no snapshot, 1: snapshot_take, 2: save_nn and fsync on the training thread
+double samples_per_second(NN* nn, TYPE** inputs, TYPE** outputs, int mode, int every) {
+    Snapshotter* snapshotter = (mode == 1) ? snapshot_start(nn, SNAPSHOT_FILE) : NULL;
+
+    double start = now();
+    for (int b = 0; b < NUM_BATCHES; b++) {
+        reset_grad(nn);
+        calculate_grad(nn, &inputs[b * BATCH_SIZE], &outputs[b * BATCH_SIZE], BATCH_SIZE);
+        optimise_parameters(nn, LEARNING_RATE, BATCH_SIZE);
+
+        if ((b + 1) % every == 0) {
+            if (mode == 1) snapshot_take(snapshotter, 0, (b + 1) * BATCH_SIZE, LEARNING_RATE);
+            if (mode == 2) {
+                save_nn(nn, SNAPSHOT_FILE);
+                int fd = open(SNAPSHOT_FILE, O_RDONLY);
+                fsync(fd);
+                close(fd);
+            }
+        }
+    }
+    double elapsed = now() - start;
+
+    if (snapshotter != NULL) snapshot_stop(snapshotter);
+    return NUM_BATCHES * BATCH_SIZE / elapsed;
+}
+
+int main() {
+    TYPE** inputs;
+    TYPE** outputs;
+    srand(42);
+    random_samples(NUM_BATCHES * BATCH_SIZE, 784, 10, &inputs, &outputs);
+
+    NN* nn = createNN(784, 10, 4, 128);
+    samples_per_second(nn, inputs, outputs, 0, 1); // warm up
+    double baseline = samples_per_second(nn, inputs, outputs, 0, 1);
+    printf("no snapshot:           %8.0f samples/s\n", baseline);
+
+    int every[] = {1, 10, 100};
+    for (int e = 0; e < 3; e++) {
+        double background = samples_per_second(nn, inputs, outputs, 1, every[e]);
+        double blocking = samples_per_second(nn, inputs, outputs, 2, every[e]);
+        printf("every %3d batches: background %8.0f samples/s (%+5.1f%%), save_nn %8.0f samples/s (%+5.1f%%)\n",
+               every[e], background, (background / baseline - 1) * 100, blocking, (blocking / baseline - 1) * 100);
+    }
+
+    remove(SNAPSHOT_FILE);
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Training throughput of the MNIST-sized MLP (784-128-128-128-10, batches of
+// 32) without telemetry, and with a record per batch (timings and gradient
+// norm) written to a JSON-lines file by the telemetry thread. Uses random data.
+//
+// gcc -O2 bench_telemetry.c MLP.c telemetry.c timer.c samples.c -lm -lpthread -o bench_telemetry
+
+#include "MLP.h"
+#include "telemetry.h"
+#include "timer.h"
+#include "samples.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TYPE double
+#define LEARNING_RATE 1e-3
+#define BATCH_SIZE 32
+#define NUM_BATCHES 300
+#define TELEMETRY_FILE "bench.jsonl"
+
+double samples_per_second(NN* nn, TYPE** inputs, TYPE** outputs, Telemetry* telemetry) {
+    double begin = now();
+    for (int b = 0; b < NUM_BATCHES; b++) {
+        double start = now();
+        reset_grad(nn);
+        calculate_grad(nn, &inputs[b * BATCH_SIZE], &outputs[b * BATCH_SIZE], BATCH_SIZE);
+        double grad_end = now();
+        optimise_parameters(nn, LEARNING_RATE, BATCH_SIZE);
+        double end = now();
+
+        if (telemetry != NULL) {
+            TelemetryRecord record = {
+                .type = TELEMETRY_BATCH,
+                .batch = b * BATCH_SIZE,
+                .loss = nn->loss / (BATCH_SIZE * 10),
+                .samples_per_second = BATCH_SIZE / (end - start),
+                .grad_time = grad_end - start,
+                .optimise_time = end - grad_end,
+                .grad_norm = grad_norm(nn),
+            };
+            telemetry_push(telemetry, &record);
+        }
+    }
+    return NUM_BATCHES * BATCH_SIZE / (now() - begin);
+}
+
+int main() {
+    TYPE** inputs;
+    TYPE** outputs;
+    srand(42);
+    random_samples(NUM_BATCHES * BATCH_SIZE, 784, 10, &inputs, &outputs);
+
+    NN* nn = createNN(784, 10, 4, 128);
+    samples_per_second(nn, inputs, outputs, NULL); // warm up
+
+    // alternate the runs so that drifts of the machine affect both the same way
+    double without = 0.0, with = 0.0;
+    for (int r = 0; r < 3; r++) {
+        without += samples_per_second(nn, inputs, outputs, NULL) / 3;
+        Telemetry* telemetry = telemetry_start(TELEMETRY_FILE, TELEMETRY_JSON, NULL, NULL);
+        with += samples_per_second(nn, inputs, outputs, telemetry) / 3;
+        telemetry_stop(telemetry);
+    }
+
+    printf("no telemetry:   %8.0f samples/s\n", without);
+    printf("telemetry:      %8.0f samples/s (%+5.1f%%)\n", with, (with / without - 1) * 100);
+
+    remove(TELEMETRY_FILE);
+    return 0;
+}
@@ -1,4 +1,12 @@
+// Trains the MLP on MNIST (data/), with background snapshots and telemetry.
+//
+// gcc -O2 main.c MLP.c mnist.c snapshot.c telemetry.c timer.c -lm -lpthread -o main
+
 #include "MLP.h"
+#include "mnist.h"
+#include "snapshot.h"
+#include "telemetry.h"
+#include "timer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -10,70 +18,57 @@
 #define NUM_LAYERS 3
 #define TRAINING_CYCLES 100
 
+#define SNAPSHOT_FILE "checkpoint.snp"
+#define SNAPSHOT_EVERY 50 // batches
+
+#define TELEMETRY_FILE "training.jsonl"
+#define TELEMETRY_FORMAT TELEMETRY_JSON // or TELEMETRY_CSV
+#define VISUALISE 1 // print the cycle summaries and a digit per cycle from the telemetry thread
+
 #define RED "\033[31m"
 #define GREEN "\033[32m"
 #define YELLOW "\033[33m"
 #define BLUE "\033[34m"
 #define RESET "\033[0m"
 
-
-
-// Read big-endian 4-byte integer
-uint32_t read_uint32(FILE *fp) {
-    uint8_t bytes[4];
-    fread(bytes, 1, 4, fp);
-    return (bytes[0]<<24) | (bytes[1]<<16) | (bytes[2]<<8) | bytes[3];
-}
-
-// Read MNIST images
-unsigned char* read_mnist_images(const char *filename, int *num_images, int *rows, int *cols) {
-    FILE *fp = fopen(filename, "rb");
-    if (!fp) {
-        printf("Cannot open %s\n", filename);
-        return NULL;
-    }
-
-    uint32_t magic = read_uint32(fp);
-    if (magic != 2051) {
-        printf("Invalid MNIST image file!\n");
-        fclose(fp);
-        return NULL;
-    }
-
-    *num_images = read_uint32(fp);
-    *rows = read_uint32(fp);
-    *cols = read_uint32(fp);
-
-    size_t size = (*num_images) * (*rows) * (*cols);
-    unsigned char *data = (unsigned char*)malloc(size);
-    fread(data, 1, size, fp);
-    fclose(fp);
-    return data;
-}
-
-// Read MNIST labels
-unsigned char* read_mnist_labels(const char *filename, int *num_labels) {
-    FILE *fp = fopen(filename, "rb");
-    if (!fp) {
-        printf("Cannot open %s\n", filename);
-        return NULL;
-    }
-
-    uint32_t magic = read_uint32(fp);
-    if (magic != 2049) {
-        printf("Invalid MNIST label file!\n");
-        fclose(fp);
-        return NULL;
+typedef struct Visualisation {
+    TYPE **inputs;
+    int rows;
+    int cols;
+} Visualisation;
+
+// Telemetry sink, runs on the telemetry thread
+void print_record(const TelemetryRecord *record, void *context) {
+    Visualisation *v = context;
+
+    if (record->type == TELEMETRY_CYCLE) {
+        printf("Cycle %d: Loss = %f, %.0f samples/s\n", record->cycle, record->loss, record->samples_per_second);
+    } else if (record->type == TELEMETRY_PREDICTION) {
+        TYPE *input = v->inputs[record->image];
+        for(int k = 0; k < v->rows * v->cols; k++) {
+            if (k > 0 && k % v->cols == 0) {
+                printf("\n");
+            }
+            if( input[k] > 0.5) {
+                printf(BLUE "#");
+            } else {
+                printf(".");
+            }
+            printf(RESET);
+        }
+        printf("\nOutput: ");
+        for(int k = 0; k < record->num_outputs; k++) {
+            if (record->outputs[k] > 0.7) {
+                printf(GREEN "%d: %f " RESET, k, record->outputs[k]);
+            } else {
+                printf(RED "%d: %f " RESET, k, record->outputs[k]);
+            }
+            printf(RESET);
+        }
+        printf("Actual: %d\n\n", record->label);
     }
-
-    *num_labels = read_uint32(fp);
-    unsigned char *labels = (unsigned char*)malloc(*num_labels);
-    fread(labels, 1, *num_labels, fp);
-    fclose(fp);
-    return labels;
 }
 
-
 int main() {
 
     // create some inputs and outputs
@@ -131,54 +126,92 @@ int main() {
     srand(42); // Seed for reproducibility
     NN* nn = createNN(nin, nout, nlayers, n_neurons);
 
-    for (int i = 0; i < TRAINING_CYCLES; i++) {
-        printf("Training cycle %d\n", i + 1);
+    // Resume from the last snapshot if there is one (plain SGD has no other state)
+    int start_cycle = 0, start_batch = 0;
+    TYPE learning_rate = LEARNING_RATE;
+    if (snapshot_load(nn, SNAPSHOT_FILE, &start_cycle, &start_batch, &learning_rate) == 0) {
+        printf("Resuming from cycle %d, image %d\n", start_cycle + 1, start_batch);
+    }
+    Snapshotter* snapshotter = snapshot_start(nn, SNAPSHOT_FILE);
+    int batches = 0;
 
-        // calculate the current loss
-        TYPE total_loss = 0.0;
-        for (int j = 0; j < 100; j++) {
-            TYPE* output = callNN(nn, inputs[j]);
-            for (int k = 0; k < nout; k++) {
-                TYPE error = outputs[j][k] - output[k];
-                total_loss += error * error; // Mean Squared Error
-            }
-        }
-        printf("Cycle %d: Loss = %f\n", i, total_loss / 100);
+    Visualisation visualisation = {inputs, rows, cols};
+    Telemetry* telemetry = telemetry_start(TELEMETRY_FILE, TELEMETRY_FORMAT, VISUALISE ? print_record : NULL, &visualisation);
 
-        for (int j = 0; j < num_images; j += 32) {
+    for (int i = start_cycle; i < TRAINING_CYCLES; i++) {
+        // The loss of the cycle is the mean loss of its batches, given by calculate_grad
+        TelemetryRecord cycle = {.type = TELEMETRY_CYCLE, .cycle = i};
+        int cycle_samples = 0;
+        double cycle_start = now();
+
+        for (int j = (i == start_cycle) ? start_batch : 0; j < num_images; j += 32) {
             int batch_size = (j + 32 > num_images) ? num_images - j : 32;
+
+            double start = now();
             reset_grad(nn);
             calculate_grad(nn, &inputs[j], &outputs[j], batch_size);
-            optimise_parameters(nn, LEARNING_RATE, batch_size);
+            double grad_end = now();
+            TYPE norm = grad_norm(nn);
+            double optimise_start = now();
+            optimise_parameters(nn, learning_rate, batch_size);
+            double end = now();
+
+            TelemetryRecord batch = {
+                .type = TELEMETRY_BATCH,
+                .cycle = i,
+                .batch = j,
+                .loss = nn->loss / (batch_size * nout),
+                .samples_per_second = batch_size / (end - start),
+                .grad_time = grad_end - start,
+                .optimise_time = end - optimise_start,
+                .grad_norm = norm,
+            };
+            telemetry_push(telemetry, &batch);
+
+            cycle.loss += nn->loss;
+            cycle.grad_time += batch.grad_time;
+            cycle.optimise_time += batch.optimise_time;
+            cycle_samples += batch_size;
+
+            if (++batches % SNAPSHOT_EVERY == 0) {
+                if (j + batch_size < num_images) {
+                    snapshot_take(snapshotter, i, j + batch_size, learning_rate);
+                } else {
+                    snapshot_take(snapshotter, i + 1, 0, learning_rate);
+                }
+            }
         }
-        printf("Cycle %d: Gradients calculated and parameters updated.\n", i);
 
+        cycle.loss /= cycle_samples * nout;
+        cycle.samples_per_second = cycle_samples / (now() - cycle_start);
+        telemetry_push(telemetry, &cycle);
 
+        // Output for an image that is not trained on, records hold at most
+        // TELEMETRY_MAX_OUTPUTS outputs
         TYPE* output = callNN(nn, inputs[num_images + i]);
-        for(int k = 0; k < rows * cols; k++) {
-            if (k > 0 && k % cols == 0) {
-                printf("\n");
-            }
-            if( inputs[num_images + i][k] > 0.5) {
-                printf(BLUE "#");
-            } else {
-                printf(".");
-            }
-            printf(RESET);
+        TelemetryRecord prediction = {
+            .type = TELEMETRY_PREDICTION,
+            .cycle = i,
+            .image = num_images + i,
+            .label = labels[num_images + i],
+            .num_outputs = (nout < TELEMETRY_MAX_OUTPUTS) ? nout : TELEMETRY_MAX_OUTPUTS,
+        };
+        for (int k = 0; k < prediction.num_outputs; k++) {
+            prediction.outputs[k] = output[k];
         }
-        printf("\nOutput: ");
-        for(int k = 0; k < nout; k++) {
-            if (output[k] > 0.7) {
-                printf(GREEN "%d: %f " RESET, k, output[k]);
-            } else {
-                printf(RED "%d: %f " RESET, k, output[k]);
-            }
-            printf(RESET);
-        }
-        printf("Actual: %d\n\n", labels[num_images + i]);
+        free(output);
+        telemetry_push(telemetry, &prediction);
+    }
 
+    long dropped = telemetry_stop(telemetry);
+    if (dropped > 0) {
+        printf("%ld telemetry records dropped\n", dropped);
     }
 
+    // A finished run leaves no checkpoint, the next run starts from scratch
+    snapshot_stop(snapshotter);
+    remove(SNAPSHOT_FILE);
+
     return 0;
 }
 
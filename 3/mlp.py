@@ -0,0 +1,150 @@
+# Python interface to the MLP of this directory, through ctypes and
+# libmlp.so (see mlp_capi.c). Inputs, targets, outputs and weights are
+# exchanged through the buffer protocol (NumPy arrays, array.array, ...) as
+# C-contiguous float64 data, without copies at the boundary (predict stages
+# the inputs feature by feature inside the library). ctypes releases the GIL
+# during every call into the library.
+
+import array
+import ctypes
+import os
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+_lib = ctypes.CDLL(os.environ.get("MLP_LIBRARY", os.path.join(os.path.dirname(os.path.abspath(__file__)), "libmlp.so")))
+
+_double_p = ctypes.POINTER(ctypes.c_double)
+
+_lib.mlp_create.restype = ctypes.c_void_p
+_lib.mlp_create.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_uint]
+_lib.mlp_free.restype = None
+_lib.mlp_free.argtypes = [ctypes.c_void_p]
+_lib.mlp_num_layers.argtypes = [ctypes.c_void_p]
+_lib.mlp_layer_shape.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+_lib.mlp_layer_weights.restype = _double_p
+_lib.mlp_layer_weights.argtypes = [ctypes.c_void_p, ctypes.c_int]
+_lib.mlp_get_biases.argtypes = [ctypes.c_void_p, ctypes.c_int, _double_p]
+_lib.mlp_set_biases.argtypes = [ctypes.c_void_p, ctypes.c_int, _double_p]
+_lib.mlp_train_on_batch.restype = ctypes.c_double
+_lib.mlp_train_on_batch.argtypes = [ctypes.c_void_p, _double_p, _double_p, ctypes.c_int, ctypes.c_double]
+_lib.mlp_predict.argtypes = [ctypes.c_void_p, _double_p, _double_p, ctypes.c_int]
+_lib.mlp_save.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+_lib.mlp_load.restype = ctypes.c_void_p
+_lib.mlp_load.argtypes = [ctypes.c_char_p]
+
+
+class _Py_buffer(ctypes.Structure):
+    _fields_ = [("buf", ctypes.c_void_p), ("obj", ctypes.py_object), ("len", ctypes.c_ssize_t),
+                ("itemsize", ctypes.c_ssize_t), ("readonly", ctypes.c_int), ("ndim", ctypes.c_int),
+                ("format", ctypes.c_char_p), ("shape", ctypes.c_void_p), ("strides", ctypes.c_void_p),
+                ("suboffsets", ctypes.c_void_p), ("internal", ctypes.c_void_p)]
+
+
+ctypes.pythonapi.PyObject_GetBuffer.argtypes = [ctypes.py_object, ctypes.POINTER(_Py_buffer), ctypes.c_int]
+ctypes.pythonapi.PyBuffer_Release.argtypes = [ctypes.POINTER(_Py_buffer)]
+ctypes.pythonapi.PyBuffer_Release.restype = None
+
+
+def _pointer(buffer, width, writable=False):
+    """Pointer to the data of a C-contiguous float64 buffer, and its number of rows"""
+    view = memoryview(buffer)
+    if view.format not in ("d", "<d", "=d") or not view.c_contiguous:
+        raise ValueError("expected a C-contiguous float64 buffer")
+    if writable and view.readonly:
+        raise ValueError("expected a writable buffer")
+    if view.nbytes % (8 * width) != 0:
+        raise ValueError(f"expected rows of {width} values")
+    if not view.readonly:
+        data = (ctypes.c_double * (view.nbytes // 8)).from_buffer(view)
+        return ctypes.cast(data, _double_p), view.nbytes // (8 * width)
+
+    # from_buffer only takes writable buffers, the address of a read-only one
+    # stays valid as long as view (kept by the pointer) holds its export
+    exported = _Py_buffer()
+    ctypes.pythonapi.PyObject_GetBuffer(view, ctypes.byref(exported), 0)
+    address = exported.buf
+    ctypes.pythonapi.PyBuffer_Release(ctypes.byref(exported))
+    pointer = ctypes.cast(address, _double_p)
+    pointer._view = view
+    return pointer, view.nbytes // (8 * width)
+
+
+def _empty(rows, cols):
+    if numpy is not None:
+        return numpy.empty((rows, cols))
+    return array.array("d", bytes(8 * rows * cols))
+
+
+class MLP:
+    def __init__(self, nin, nout, nlayers, num_neurons, seed=42, _handle=None):
+        self._nn = _handle if _handle is not None else _lib.mlp_create(nin, nout, nlayers, num_neurons, seed)
+        if not self._nn:
+            raise RuntimeError("could not create the network")
+        self.nin = self.layer_shape(0)[1]
+        self.nout = self.layer_shape(len(self) - 1)[0]
+
+    @classmethod
+    def load(cls, filename):
+        handle = _lib.mlp_load(os.fsencode(filename))
+        if not handle:
+            raise IOError(f"could not load {filename}")
+        return cls(0, 0, 0, 0, _handle=handle)
+
+    def save(self, filename):
+        if _lib.mlp_save(self._nn, os.fsencode(filename)) != 0:
+            raise IOError(f"could not save {filename}")
+
+    def __del__(self):
+        if getattr(self, "_nn", None):
+            _lib.mlp_free(self._nn)
+            self._nn = None
+
+    def __len__(self):
+        return _lib.mlp_num_layers(self._nn)
+
+    def layer_shape(self, layer):
+        num_neurons, num_weights = ctypes.c_int(), ctypes.c_int()
+        if _lib.mlp_layer_shape(self._nn, layer, ctypes.byref(num_neurons), ctypes.byref(num_weights)) != 0:
+            raise IndexError(layer)
+        return num_neurons.value, num_weights.value
+
+    def weights(self, layer):
+        """num_neurons x num_weights view of the weights of a layer, shared with the network"""
+        rows, cols = self.layer_shape(layer)
+        data = (ctypes.c_double * (rows * cols)).from_address(ctypes.addressof(_lib.mlp_layer_weights(self._nn, layer).contents))
+        # The view (through .base, or .obj of the memoryview) keeps the network alive
+        data._owner = self
+        if numpy is not None:
+            return numpy.ctypeslib.as_array(data).reshape(rows, cols)
+        return memoryview(data).cast("B").cast("d", [rows, cols])
+
+    def biases(self, layer):
+        rows, _ = self.layer_shape(layer)
+        biases = _empty(1, rows)
+        _lib.mlp_get_biases(self._nn, layer, _pointer(biases, rows, writable=True)[0])
+        return biases.reshape(rows) if numpy is not None else biases
+
+    def set_biases(self, layer, biases):
+        rows, _ = self.layer_shape(layer)
+        _lib.mlp_set_biases(self._nn, layer, _pointer(biases, rows)[0])
+
+    def train_on_batch(self, inputs, targets, learning_rate):
+        """One gradient step, returns the mean squared error of the batch before it"""
+        inputs_p, samples = _pointer(inputs, self.nin)
+        targets_p, target_samples = _pointer(targets, self.nout)
+        if samples != target_samples:
+            raise ValueError("inputs and targets have a different number of samples")
+        return _lib.mlp_train_on_batch(self._nn, inputs_p, targets_p, samples, learning_rate)
+
+    def predict(self, inputs, outputs=None):
+        inputs_p, samples = _pointer(inputs, self.nin)
+        if outputs is None:
+            outputs = _empty(samples, self.nout)
+        outputs_p, output_samples = _pointer(outputs, self.nout, writable=True)
+        if samples != output_samples:
+            raise ValueError("inputs and outputs have a different number of samples")
+        _lib.mlp_predict(self._nn, inputs_p, outputs_p, samples)
+        return outputs
@@ -0,0 +1,100 @@
+// Flat C interface of the MLP for ctypes (see mlp.py): only ints, doubles,
+// contiguous double arrays and an opaque NN pointer cross the boundary.
+// Samples are rows of a samples_count x nin (or x nout) array, they are
+// read and written in place. Only mlp_predict copies the inputs, into the
+// feature-major layout of callNN_batch_into.
+//
+// gcc -O2 -shared -fPIC mlp_capi.c MLP.c -lm -o libmlp.so
+
+#include <stdlib.h>
+#include "MLP.h"
+
+#define TYPE double
+
+NN* mlp_create(int nin, int nout, int nlayers, int num_neurons, unsigned int seed) {
+    return createNN_seeded(nin, nout, nlayers, num_neurons, seed, INIT_DEFAULT);
+}
+
+void mlp_free(NN* nn) {
+    freeNN(nn);
+}
+
+int mlp_num_layers(NN* nn) {
+    return nn->num_layers;
+}
+
+int mlp_layer_shape(NN* nn, int layer, int* num_neurons, int* num_weights) {
+    if (layer < 0 || layer >= nn->num_layers) return -1;
+    *num_neurons = nn->layers[layer].num_neurons;
+    *num_weights = nn->layers[layer].neurons[0].num_weights;
+    return 0;
+}
+
+// num_neurons x num_weights block, shared with the caller
+TYPE* mlp_layer_weights(NN* nn, int layer) {
+    return nn->layers[layer].neurons[0].weights;
+}
+
+// Biases are stored in the neurons, so they are copied
+int mlp_get_biases(NN* nn, int layer, TYPE* biases) {
+    for (int j = 0; j < nn->layers[layer].num_neurons; j++) {
+        biases[j] = nn->layers[layer].neurons[j].bias;
+    }
+    return 0;
+}
+
+int mlp_set_biases(NN* nn, int layer, const TYPE* biases) {
+    for (int j = 0; j < nn->layers[layer].num_neurons; j++) {
+        nn->layers[layer].neurons[j].bias = biases[j];
+    }
+    return 0;
+}
+
+// One gradient step on a batch, returns the mean squared error of the
+// batch before the step
+TYPE mlp_train_on_batch(NN* nn, TYPE* inputs, TYPE* targets, int samples_count, TYPE learning_rate) {
+    int nin = nn->layers[0].neurons[0].num_weights;
+    int nout = nn->layers[nn->num_layers - 1].num_neurons;
+
+    TYPE** input_rows = malloc(samples_count * sizeof(TYPE*));
+    TYPE** target_rows = malloc(samples_count * sizeof(TYPE*));
+    for (int i = 0; i < samples_count; i++) {
+        input_rows[i] = &inputs[i * nin];
+        target_rows[i] = &targets[i * nout];
+    }
+
+    // calculate_grad leaves the summed squared error of the batch in nn->loss
+    reset_grad(nn);
+    calculate_grad(nn, input_rows, target_rows, samples_count);
+    TYPE loss = nn->loss;
+
+    optimise_parameters(nn, learning_rate, samples_count);
+
+    free(input_rows);
+    free(target_rows);
+    return loss / (samples_count * nout);
+}
+
+// The outputs are written straight into the caller's array, the inputs are
+// staged feature by feature inside callNN_batch_into (an internal copy)
+int mlp_predict(NN* nn, TYPE* inputs, TYPE* outputs, int samples_count) {
+    int nin = nn->layers[0].neurons[0].num_weights;
+
+    TYPE** input_rows = malloc(samples_count * sizeof(TYPE*));
+    for (int i = 0; i < samples_count; i++) {
+        input_rows[i] = &inputs[i * nin];
+    }
+
+    callNN_batch_into(nn, input_rows, samples_count, outputs);
+
+    free(input_rows);
+    return 0;
+}
+
+int mlp_save(NN* nn, const char* filename) {
+    return save_nn(nn, filename);
+}
+
+NN* mlp_load(const char* filename) {
+    return load_nn(filename);
+}
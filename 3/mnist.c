@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "mnist.h"
+
+// Read big-endian 4-byte integer
+uint32_t read_uint32(FILE *fp) {
+    uint8_t bytes[4];
+    fread(bytes, 1, 4, fp);
+    return (bytes[0]<<24) | (bytes[1]<<16) | (bytes[2]<<8) | bytes[3];
+}
+
+// Read MNIST images
+unsigned char* read_mnist_images(const char *filename, int *num_images, int *rows, int *cols) {
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        printf("Cannot open %s\n", filename);
+        return NULL;
+    }
+
+    uint32_t magic = read_uint32(fp);
+    if (magic != 2051) {
+        printf("Invalid MNIST image file!\n");
+        fclose(fp);
+        return NULL;
+    }
+
+    *num_images = read_uint32(fp);
+    *rows = read_uint32(fp);
+    *cols = read_uint32(fp);
+
+    size_t size = (*num_images) * (*rows) * (*cols);
+    unsigned char *data = (unsigned char*)malloc(size);
+    fread(data, 1, size, fp);
+    fclose(fp);
+    return data;
+}
+
+// Read MNIST labels
+unsigned char* read_mnist_labels(const char *filename, int *num_labels) {
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        printf("Cannot open %s\n", filename);
+        return NULL;
+    }
+
+    uint32_t magic = read_uint32(fp);
+    if (magic != 2049) {
+        printf("Invalid MNIST label file!\n");
+        fclose(fp);
+        return NULL;
+    }
+
+    *num_labels = read_uint32(fp);
+    unsigned char *labels = (unsigned char*)malloc(*num_labels);
+    fread(labels, 1, *num_labels, fp);
+    fclose(fp);
+    return labels;
+}
@@ -0,0 +1,13 @@
+#ifndef MNIST_H
+#define MNIST_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+uint32_t read_uint32(FILE *fp);
+
+unsigned char* read_mnist_images(const char *filename, int *num_images, int *rows, int *cols);
+
+unsigned char* read_mnist_labels(const char *filename, int *num_labels);
+
+#endif
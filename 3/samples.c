@@ -0,0 +1,13 @@
+#include <stdlib.h>
+#include "samples.h"
+
+void random_samples(int num_samples, int nin, int nout, TYPE*** inputs, TYPE*** targets) {
+    *inputs = malloc(num_samples * sizeof(TYPE*));
+    *targets = malloc(num_samples * sizeof(TYPE*));
+    for (int i = 0; i < num_samples; i++) {
+        (*inputs)[i] = malloc(nin * sizeof(TYPE));
+        (*targets)[i] = malloc(nout * sizeof(TYPE));
+        for (int k = 0; k < nin; k++) (*inputs)[i][k] = (TYPE)rand() / (TYPE)RAND_MAX;
+        for (int k = 0; k < nout; k++) (*targets)[i][k] = (k == i % nout) ? 1.0 : -1.0; // One-hot like MNIST
+    }
+}
@@ -0,0 +1,13 @@
+#ifndef SAMPLES_H
+#define SAMPLES_H
+
+#include "MLP.h"
+
+#define TYPE double
+
+// Synthetic training data for the benchmarks and check/: num_samples inputs
+// of nin values uniform in [0, 1] drawn with rand() (seed it first), and
+// one-hot targets in {-1, 1} whose class cycles over the nout outputs
+void random_samples(int num_samples, int nin, int nout, TYPE*** inputs, TYPE*** targets);
+
+#endif
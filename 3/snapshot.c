@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "snapshot.h"
+
+#define TYPE double
+
+long count_parameters(NN* nn) {
+    long count = 0;
+    for (int i = 0; i < nn->num_layers; i++) {
+        count += (long)nn->layers[i].num_neurons * (nn->layers[i].neurons[0].num_weights + 1);
+    }
+    return count;
+}
+
+// Same order as save_nn: the weights then the bias of every neuron
+void copy_parameters(NN* nn, TYPE* buffer) {
+    for (int i = 0; i < nn->num_layers; i++) {
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
+            Neuron* neuron = &nn->layers[i].neurons[j];
+            memcpy(buffer, neuron->weights, neuron->num_weights * sizeof(TYPE));
+            buffer[neuron->num_weights] = neuron->bias;
+            buffer += neuron->num_weights + 1;
+        }
+    }
+}
+
+void restore_parameters(NN* nn, const TYPE* buffer) {
+    for (int i = 0; i < nn->num_layers; i++) {
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
+            Neuron* neuron = &nn->layers[i].neurons[j];
+            memcpy(neuron->weights, buffer, neuron->num_weights * sizeof(TYPE));
+            neuron->bias = buffer[neuron->num_weights];
+            buffer += neuron->num_weights + 1;
+        }
+    }
+}
+
+// "SNP1", cycle, batch, learning rate, num_layers, nin, the number of
+// neurons of every layer, then the parameters
+int write_snapshot(Snapshotter* s, int b) {
+    NN* nn = s->nn;
+    char* tmp_filename = malloc(strlen(s->filename) + 5);
+    sprintf(tmp_filename, "%s.tmp", s->filename);
+
+    FILE* fp = fopen(tmp_filename, "wb");
+    if (!fp) {
+        printf("Cannot open %s\n", tmp_filename);
+        free(tmp_filename);
+        return -1;
+    }
+
+    int nin = nn->layers[0].neurons[0].num_weights;
+    fwrite("SNP1", 1, 4, fp);
+    fwrite(&s->cycle[b], sizeof(int), 1, fp);
+    fwrite(&s->batch[b], sizeof(int), 1, fp);
+    fwrite(&s->learning_rate[b], sizeof(TYPE), 1, fp);
+    fwrite(&nn->num_layers, sizeof(int), 1, fp);
+    fwrite(&nin, sizeof(int), 1, fp);
+    for (int i = 0; i < nn->num_layers; i++) {
+        fwrite(&nn->layers[i].num_neurons, sizeof(int), 1, fp);
+    }
+    fwrite(s->buffers[b], sizeof(TYPE), s->num_parameters, fp);
+
+    int failed = fflush(fp) != 0 || ferror(fp) || fsync(fileno(fp)) != 0;
+    fclose(fp);
+    if (failed || rename(tmp_filename, s->filename) != 0) {
+        printf("Cannot write %s\n", s->filename);
+        free(tmp_filename);
+        return -1;
+    }
+    free(tmp_filename);
+
+    // make the rename itself durable
+    char* dir = strdup(s->filename);
+    char* slash = strrchr(dir, '/');
+    if (slash != NULL) {
+        *slash = '\0';
+    } else {
+        strcpy(dir, ".");
+    }
+    int dir_fd = open(dir, O_RDONLY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    free(dir);
+    return 0;
+}
+
+void* writer_thread(void* arg) {
+    Snapshotter* s = arg;
+
+    pthread_mutex_lock(&s->lock);
+    while (1) {
+        while (s->pending < 0 && !s->stop) {
+            pthread_cond_wait(&s->cond, &s->lock);
+        }
+        if (s->pending < 0) break; // stopped and nothing left to write
+
+        s->writing = s->pending;
+        s->pending = -1;
+        pthread_mutex_unlock(&s->lock);
+
+        int result = write_snapshot(s, s->writing);
+
+        pthread_mutex_lock(&s->lock);
+        if (result == 0) s->written++;
+        s->writing = -1;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+Snapshotter* snapshot_start(NN* nn, const char* filename) {
+    Snapshotter* s = malloc(sizeof(Snapshotter));
+    s->nn = nn;
+    s->filename = strdup(filename);
+    s->num_parameters = count_parameters(nn);
+    s->buffers[0] = malloc(s->num_parameters * sizeof(TYPE));
+    s->buffers[1] = malloc(s->num_parameters * sizeof(TYPE));
+    s->pending = -1;
+    s->writing = -1;
+    s->stop = 0;
+    s->written = 0;
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    pthread_create(&s->thread, NULL, writer_thread, s);
+    return s;
+}
+
+int snapshot_take(Snapshotter* s, int cycle, int batch, TYPE learning_rate) {
+    pthread_mutex_lock(&s->lock);
+
+    // the writer only switches buffers with the lock held
+    int b = (s->writing == 0) ? 1 : 0;
+    copy_parameters(s->nn, s->buffers[b]);
+    s->cycle[b] = cycle;
+    s->batch[b] = batch;
+    s->learning_rate[b] = learning_rate;
+    s->pending = b;
+
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    return 0;
+}
+
+int snapshot_stop(Snapshotter* s) {
+    pthread_mutex_lock(&s->lock);
+    s->stop = 1;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+
+    int written = s->written;
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->cond);
+    free(s->buffers[0]);
+    free(s->buffers[1]);
+    free(s->filename);
+    free(s);
+    return written;
+}
+
+int snapshot_load(NN* nn, const char* filename, int* cycle, int* batch, TYPE* learning_rate) {
+    FILE* fp = fopen(filename, "rb");
+    if (!fp) {
+        return -1;
+    }
+
+    char magic[4];
+    int num_layers, nin, saved_cycle, saved_batch;
+    TYPE saved_learning_rate;
+    int valid = fread(magic, 1, 4, fp) == 4 && memcmp(magic, "SNP1", 4) == 0
+        && fread(&saved_cycle, sizeof(int), 1, fp) == 1 && fread(&saved_batch, sizeof(int), 1, fp) == 1
+        && fread(&saved_learning_rate, sizeof(TYPE), 1, fp) == 1
+        && fread(&num_layers, sizeof(int), 1, fp) == 1 && fread(&nin, sizeof(int), 1, fp) == 1
+        && num_layers == nn->num_layers && nin == nn->layers[0].neurons[0].num_weights;
+
+    for (int i = 0; valid && i < num_layers; i++) {
+        int num_neurons;
+        valid = fread(&num_neurons, sizeof(int), 1, fp) == 1 && num_neurons == nn->layers[i].num_neurons;
+    }
+
+    // nn and the position are only changed if the whole snapshot could be read
+    long num_parameters = count_parameters(nn);
+    TYPE* buffer = malloc(num_parameters * sizeof(TYPE));
+    valid = valid && fread(buffer, sizeof(TYPE), num_parameters, fp) == (size_t)num_parameters;
+    fclose(fp);
+
+    if (!valid) {
+        printf("Invalid snapshot %s, starting from scratch\n", filename);
+        free(buffer);
+        return -1;
+    }
+    restore_parameters(nn, buffer);
+    free(buffer);
+    *cycle = saved_cycle;
+    *batch = saved_batch;
+    *learning_rate = saved_learning_rate;
+    return 0;
+}
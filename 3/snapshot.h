@@ -0,0 +1,48 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <pthread.h>
+#include "MLP.h"
+
+#define TYPE double
+
+// Background checkpoints of the training state. snapshot_take copies the
+// parameters into one of two staging buffers (a memcpy per neuron), a
+// background thread writes it to a temporary file, fsyncs it and renames it
+// over the checkpoint, so the file is always a complete snapshot.
+// Link with -lpthread.
+
+typedef struct Snapshotter {
+    NN* nn;
+    char* filename;
+    long num_parameters;
+
+    TYPE* buffers[2]; // parameters in the order of save_nn
+    int cycle[2];
+    int batch[2];
+    TYPE learning_rate[2];
+
+    int pending; // buffer waiting for the writer, -1 if none
+    int writing; // buffer being written, -1 if none
+    int stop;
+    int written; // number of snapshots on disk
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} Snapshotter;
+
+Snapshotter* snapshot_start(NN* nn, const char* filename);
+
+// Never waits for the disk, a snapshot that was not picked up by the
+// writer yet is replaced by the new one
+int snapshot_take(Snapshotter* s, int cycle, int batch, TYPE learning_rate);
+
+// Writes the last snapshot taken and stops the writer thread
+int snapshot_stop(Snapshotter* s);
+
+// Restores the parameters of nn (which must have the same shape) and the
+// training position from a checkpoint, returns -1 if there is none
+int snapshot_load(NN* nn, const char* filename, int* cycle, int* batch, TYPE* learning_rate);
+
+#endif
@@ -0,0 +1,179 @@
+// Hyperparameter sweep: trains every configuration of configs[] in one
+// process on one stream of MNIST. The images stay in bytes, each chunk of
+// images is decoded once and fed to every model while it is in cache, the
+// models of a chunk are spread over the cores with OpenMP.
+//
+// gcc -O2 -fopenmp sweep.c MLP.c mnist.c timer.c -lm -o sweep
+
+#include "MLP.h"
+#include "mnist.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#define TYPE double
+
+#define TRAINING_CYCLES 10
+#define TRAINING_IMAGES 6000 // like main.c
+#define MAX_CHUNK 4096 // chunks hold a whole number of batches of every configuration
+#define TARGET_CHUNK 256 // ~1.6 MB of decoded images, stays in cache while every model reads it
+
+typedef struct SweepConfig {
+    TYPE learning_rate;
+    int nlayers;
+    int n_neurons;
+    int batch_size;
+} SweepConfig;
+
+SweepConfig configs[] = {
+    {1e-3, 4, 128, 32}, // main.c
+    {3e-3, 4, 128, 32},
+    {1e-2, 4, 128, 32},
+    {1e-3, 3, 128, 32},
+    {1e-3, 4, 64, 32},
+    {1e-3, 4, 128, 16},
+    {3e-3, 4, 128, 64},
+};
+
+#define NUM_CONFIGS (int)(sizeof(configs) / sizeof(configs[0]))
+
+typedef struct SweepModel {
+    NN* nn;
+    TYPE loss; // sum of the squared errors of the last cycle
+    int correct;
+    double seconds; // time spent on this model
+} SweepModel;
+
+typedef struct Chunk {
+    TYPE* data; // count x nin pixels in [0, 1]
+    TYPE* target_data; // count x 10, one-hot in {-1, 1}
+    TYPE** inputs;
+    TYPE** outputs;
+    int count;
+} Chunk;
+
+int gcd(int a, int b) {
+    return (b == 0) ? a : gcd(b, a % b);
+}
+
+// Same encoding as main.c
+void decode_chunk(Chunk* chunk, unsigned char* images, unsigned char* labels, int first, int count, int nin) {
+    chunk->count = count;
+    for (int i = 0; i < count; i++) {
+        unsigned char* img_ptr = images + (long)(first + i) * nin;
+        for (int j = 0; j < nin; j++) {
+            chunk->data[(long)i * nin + j] = (TYPE)img_ptr[j] / 255.0;
+        }
+        for (int j = 0; j < 10; j++) {
+            chunk->target_data[i * 10 + j] = (j == labels[first + i]) ? 1.0 : -1.0;
+        }
+    }
+}
+
+int main() {
+    int num_images, rows, cols, num_labels, num_test, num_test_labels;
+    unsigned char* images = read_mnist_images("data/train-images.idx3-ubyte", &num_images, &rows, &cols);
+    unsigned char* labels = read_mnist_labels("data/train-labels.idx1-ubyte", &num_labels);
+    unsigned char* test_images = read_mnist_images("data/t10k-images.idx3-ubyte", &num_test, &rows, &cols);
+    unsigned char* test_labels = read_mnist_labels("data/t10k-labels.idx1-ubyte", &num_test_labels);
+    if (images == NULL || labels == NULL || test_images == NULL || test_labels == NULL) {
+        return 1;
+    }
+    int nin = rows * cols;
+    int nout = 10;
+    if (num_images > TRAINING_IMAGES) num_images = TRAINING_IMAGES;
+
+    // Smallest chunk that is a whole number of batches for every configuration
+    int chunk_size = 1;
+    for (int m = 0; m < NUM_CONFIGS; m++) {
+        chunk_size = chunk_size / gcd(chunk_size, configs[m].batch_size) * configs[m].batch_size;
+    }
+    if (chunk_size > MAX_CHUNK) {
+        printf("The batch sizes need chunks of %d images, more than %d\n", chunk_size, MAX_CHUNK);
+        return 1;
+    }
+    while (chunk_size * 2 <= TARGET_CHUNK) chunk_size *= 2;
+
+    Chunk chunk;
+    chunk.data = malloc((long)chunk_size * nin * sizeof(TYPE));
+    chunk.target_data = malloc(chunk_size * 10 * sizeof(TYPE));
+    chunk.inputs = malloc(chunk_size * sizeof(TYPE*));
+    chunk.outputs = malloc(chunk_size * sizeof(TYPE*));
+    for (int i = 0; i < chunk_size; i++) {
+        chunk.inputs[i] = &chunk.data[(long)i * nin];
+        chunk.outputs[i] = &chunk.target_data[i * 10];
+    }
+
+    SweepModel models[NUM_CONFIGS];
+    for (int m = 0; m < NUM_CONFIGS; m++) {
+        models[m].nn = createNN_seeded(nin, nout, configs[m].nlayers, configs[m].n_neurons, 42, INIT_DEFAULT);
+        models[m].seconds = 0.0;
+    }
+
+    double start = now();
+    for (int i = 0; i < TRAINING_CYCLES; i++) {
+        for (int m = 0; m < NUM_CONFIGS; m++) models[m].loss = 0.0;
+
+        for (int first = 0; first < num_images; first += chunk_size) {
+            int count = (first + chunk_size > num_images) ? num_images - first : chunk_size;
+            decode_chunk(&chunk, images, labels, first, count, nin);
+
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int m = 0; m < NUM_CONFIGS; m++) {
+                double model_start = now();
+                NN* nn = models[m].nn;
+                int batch_size = configs[m].batch_size;
+                for (int j = 0; j < count; j += batch_size) {
+                    int size = (j + batch_size > count) ? count - j : batch_size;
+                    reset_grad(nn);
+                    calculate_grad(nn, &chunk.inputs[j], &chunk.outputs[j], size);
+                    optimise_parameters(nn, configs[m].learning_rate, size);
+                    models[m].loss += nn->loss;
+                }
+                models[m].seconds += now() - model_start;
+            }
+        }
+
+        printf("Cycle %d:", i);
+        for (int m = 0; m < NUM_CONFIGS; m++) {
+            printf(" %f", models[m].loss / ((TYPE)num_images * nout));
+        }
+        printf("\n");
+    }
+    double training_time = now() - start;
+
+    // Accuracy on the test set, same chunked stream
+    for (int m = 0; m < NUM_CONFIGS; m++) models[m].correct = 0;
+    for (int first = 0; first < num_test; first += chunk_size) {
+        int count = (first + chunk_size > num_test) ? num_test - first : chunk_size;
+        decode_chunk(&chunk, test_images, test_labels, first, count, nin);
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int m = 0; m < NUM_CONFIGS; m++) {
+            TYPE* outputs = callNN_batch(models[m].nn, chunk.inputs, count);
+            for (int i = 0; i < count; i++) {
+                int best = 0;
+                for (int k = 1; k < nout; k++) {
+                    if (outputs[i * nout + k] > outputs[i * nout + best]) best = k;
+                }
+                models[m].correct += best == test_labels[first + i];
+            }
+            free(outputs);
+        }
+    }
+
+    printf("\nlearning rate | layers | neurons | batch | final loss | accuracy | time\n");
+    for (int m = 0; m < NUM_CONFIGS; m++) {
+        printf("%13g | %6d | %7d | %5d | %10f | %7.2f%% | %.1f s\n",
+               configs[m].learning_rate, configs[m].nlayers, configs[m].n_neurons, configs[m].batch_size,
+               models[m].loss / ((TYPE)num_images * nout), 100.0 * models[m].correct / num_test, models[m].seconds);
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("\n%d models in %.1f s, peak memory %ld MB (main.c expands the training set alone to %ld MB per run)\n",
+           NUM_CONFIGS, training_time, usage.ru_maxrss / 1024, (long)num_labels * nin * (long)sizeof(TYPE) >> 20);
+
+    return 0;
+}
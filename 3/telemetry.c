@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "telemetry.h"
+
+#define TYPE double
+
+#define TELEMETRY_IDLE_NS 1000000 // writer sleep when the ring buffer is empty
+
+void write_record(Telemetry* t, const TelemetryRecord* r) {
+    static const char* types[] = {"batch", "cycle", "prediction"};
+
+    if (t->format == TELEMETRY_CSV) {
+        fprintf(t->fp, "%s,%d,%d,%.9g,%.9g,%.9g,%.9g,%.9g", types[r->type], r->cycle, r->batch,
+                r->loss, r->samples_per_second, r->grad_time, r->optimise_time, r->grad_norm);
+        if (r->type == TELEMETRY_PREDICTION) {
+            fprintf(t->fp, ",%d,%d", r->image, r->label);
+        } else {
+            fprintf(t->fp, ",,");
+        }
+        for (int k = 0; k < TELEMETRY_MAX_OUTPUTS; k++) {
+            if (r->type == TELEMETRY_PREDICTION && k < r->num_outputs) {
+                fprintf(t->fp, ",%.9g", r->outputs[k]);
+            } else {
+                fprintf(t->fp, ",");
+            }
+        }
+        fprintf(t->fp, "\n");
+        return;
+    }
+
+    fprintf(t->fp, "{\"type\":\"%s\",\"cycle\":%d", types[r->type], r->cycle);
+    if (r->type == TELEMETRY_BATCH) {
+        fprintf(t->fp, ",\"batch\":%d,\"loss\":%.9g,\"samples_per_second\":%.9g,\"grad_time\":%.9g,"
+                "\"optimise_time\":%.9g,\"grad_norm\":%.9g",
+                r->batch, r->loss, r->samples_per_second, r->grad_time, r->optimise_time, r->grad_norm);
+    } else if (r->type == TELEMETRY_CYCLE) {
+        fprintf(t->fp, ",\"loss\":%.9g,\"samples_per_second\":%.9g,\"grad_time\":%.9g,\"optimise_time\":%.9g",
+                r->loss, r->samples_per_second, r->grad_time, r->optimise_time);
+    } else {
+        fprintf(t->fp, ",\"image\":%d,\"label\":%d,\"outputs\":[", r->image, r->label);
+        for (int k = 0; k < r->num_outputs; k++) {
+            fprintf(t->fp, (k > 0) ? ",%.9g" : "%.9g", r->outputs[k]);
+        }
+        fprintf(t->fp, "]");
+    }
+    fprintf(t->fp, "}\n");
+}
+
+void* telemetry_thread(void* arg) {
+    Telemetry* t = arg;
+    struct timespec idle = {0, TELEMETRY_IDLE_NS};
+
+    while (1) {
+        // read stop before head, so that nothing pushed before stop is missed
+        int stop = atomic_load_explicit(&t->stop, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&t->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&t->head, memory_order_acquire);
+
+        if (tail == head) {
+            if (stop) break;
+            if (t->fp) fflush(t->fp);
+            nanosleep(&idle, NULL);
+            continue;
+        }
+
+        for (; tail != head; tail++) {
+            const TelemetryRecord* r = &t->records[tail & (TELEMETRY_CAPACITY - 1)];
+            if (t->fp) write_record(t, r);
+            if (t->sink) t->sink(r, t->sink_context);
+        }
+        atomic_store_explicit(&t->tail, tail, memory_order_release);
+    }
+
+    return NULL;
+}
+
+Telemetry* telemetry_start(const char* filename, int format, TelemetrySink sink, void* sink_context) {
+    Telemetry* t = malloc(sizeof(Telemetry));
+    atomic_init(&t->head, 0);
+    atomic_init(&t->tail, 0);
+    atomic_init(&t->stop, 0);
+    t->dropped = 0;
+    t->format = format;
+    t->sink = sink;
+    t->sink_context = sink_context;
+
+    t->fp = NULL;
+    if (filename != NULL) {
+        t->fp = fopen(filename, "w");
+        if (!t->fp) {
+            printf("Cannot open %s\n", filename);
+        } else if (format == TELEMETRY_CSV) {
+            fprintf(t->fp, "type,cycle,batch,loss,samples_per_second,grad_time,optimise_time,grad_norm,image,label");
+            for (int k = 0; k < TELEMETRY_MAX_OUTPUTS; k++) fprintf(t->fp, ",output_%d", k);
+            fprintf(t->fp, "\n");
+        }
+    }
+
+    pthread_create(&t->thread, NULL, telemetry_thread, t);
+    return t;
+}
+
+int telemetry_push(Telemetry* t, const TelemetryRecord* record) {
+    size_t head = atomic_load_explicit(&t->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&t->tail, memory_order_acquire);
+    if (head - tail == TELEMETRY_CAPACITY) {
+        t->dropped++;
+        return -1;
+    }
+
+    t->records[head & (TELEMETRY_CAPACITY - 1)] = *record;
+    atomic_store_explicit(&t->head, head + 1, memory_order_release);
+    return 0;
+}
+
+long telemetry_stop(Telemetry* t) {
+    atomic_store_explicit(&t->stop, 1, memory_order_release);
+    pthread_join(t->thread, NULL);
+
+    long dropped = t->dropped;
+    if (t->fp) fclose(t->fp);
+    free(t);
+    return dropped;
+}
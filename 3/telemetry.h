@@ -0,0 +1,70 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define TYPE double
+
+// Training telemetry: the training thread pushes fixed-size records into a
+// single producer / single consumer lock-free ring buffer, a background
+// thread drains it to a JSON-lines or CSV file and to an optional sink (the
+// ASCII visualisation of main.c). If the ring buffer is full, records are
+// dropped and counted, the training thread never waits.
+// Link with -lpthread.
+
+#define TELEMETRY_CAPACITY 4096 // records, must be a power of two
+
+#define TELEMETRY_JSON 0
+#define TELEMETRY_CSV 1
+
+#define TELEMETRY_BATCH 0 // one gradient step
+#define TELEMETRY_CYCLE 1 // summary of a training cycle
+#define TELEMETRY_PREDICTION 2 // output of the network for one image
+
+#define TELEMETRY_MAX_OUTPUTS 10
+
+typedef struct TelemetryRecord {
+    int type;
+    int cycle;
+    int batch; // first image of the batch
+    TYPE loss; // mean squared error
+    TYPE samples_per_second;
+    TYPE grad_time; // seconds in reset_grad and calculate_grad
+    TYPE optimise_time; // seconds in optimise_parameters
+    TYPE grad_norm;
+
+    // TELEMETRY_PREDICTION only
+    int image;
+    int label;
+    int num_outputs;
+    TYPE outputs[TELEMETRY_MAX_OUTPUTS];
+} TelemetryRecord;
+
+typedef void (*TelemetrySink)(const TelemetryRecord* record, void* context);
+
+typedef struct Telemetry {
+    TelemetryRecord records[TELEMETRY_CAPACITY];
+    atomic_size_t head; // next record written by the training thread
+    atomic_size_t tail; // next record read by the writer thread
+    atomic_int stop;
+    long dropped; // only touched by the training thread
+
+    FILE* fp;
+    int format;
+    TelemetrySink sink;
+    void* sink_context;
+
+    pthread_t thread;
+} Telemetry;
+
+// filename may be NULL to only use the sink
+Telemetry* telemetry_start(const char* filename, int format, TelemetrySink sink, void* sink_context);
+
+int telemetry_push(Telemetry* t, const TelemetryRecord* record);
+
+// Drains the remaining records and stops the writer, returns the number of dropped records
+long telemetry_stop(Telemetry* t);
+
+#endif
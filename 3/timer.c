@@ -0,0 +1,8 @@
+#include <time.h>
+#include "timer.h"
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
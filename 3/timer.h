@@ -0,0 +1,8 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+// Seconds of a monotonic clock, for the timings of main.c, the benchmarks,
+// sweep.c and check/
+double now();
+
+#endif
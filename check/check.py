@@ -0,0 +1,70 @@
+# Compares the Value engine of 1/ with the gradients of 3/ exported by
+# ./check -p net.txt
+#
+# python3 check.py net.txt
+
+import os
+import sys
+import time
+import tracemalloc
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "1"))
+from main import Value
+
+TOLERANCE = 1e-9
+
+
+def read_network(filename):
+    with open(filename) as f:
+        lines = f.read().split("\n")
+    nin, num_neurons, nlayers, nout, samples_count = map(int, lines[0].split())
+    params = [float(x) for x in lines[1].split()]
+    grads = [float(x) for x in lines[2].split()]
+    inputs, targets = [], []
+    for j in range(samples_count):
+        inputs.append([float(x) for x in lines[3 + 2 * j].split()])
+        targets.append([float(x) for x in lines[4 + 2 * j].split()])
+    sizes = [nin] + [num_neurons] * (nlayers - 1) + [nout]
+    return sizes, params, grads, inputs, targets
+
+
+def loss_and_grads(sizes, params, inputs, targets):
+    # Same layout as 3/: weights then bias of every neuron, leaky ReLU hidden layers, tanh output
+    values = [Value(p) for p in params]
+    total_loss = 0.0
+    for x, t in zip(inputs, targets):
+        act = [Value(v) for v in x]
+        p = 0
+        for l in range(1, len(sizes)):
+            out = []
+            for _ in range(sizes[l]):
+                z = values[p + sizes[l - 1]]
+                for k in range(sizes[l - 1]):
+                    z = z + values[p + k] * act[k]
+                p += sizes[l - 1] + 1
+                out.append(z.tanh() if l == len(sizes) - 1 else z.leaky_relu())
+            act = out
+        loss = Value(0.0)
+        for o, e in zip(act, t):
+            error = o - Value(e)
+            loss = loss + error * error
+        loss.backward()
+        total_loss += loss.value
+    return total_loss, [v.grad for v in values]
+
+
+if __name__ == "__main__":
+    sizes, params, grads, inputs, targets = read_network(sys.argv[1])
+
+    tracemalloc.start()
+    start = time.perf_counter()
+    loss, grads1 = loss_and_grads(sizes, params, inputs, targets)
+    elapsed = time.perf_counter() - start
+    _, peak = tracemalloc.get_traced_memory()
+    tracemalloc.stop()
+
+    max_error = max(abs(a - b) / max(1.0, abs(a) + abs(b)) for a, b in zip(grads1, grads))
+    print(f"Loss: 1/ {loss:f}")
+    print(f"Max gradient error 1/ vs 3/: {max_error:e} {'OK' if max_error <= TOLERANCE else 'FAILED'}")
+    print(f"1/: {elapsed * 1e3:10.3f} ms/step, {peak:10d} bytes")
+    sys.exit(0 if max_error <= TOLERANCE else 1)
@@ -0,0 +1,99 @@
+// Link the engine of 2/ next to the one of 3/, both define createNN and callNN
+#define main engine2_main
+#define createNN engine2_createNN
+#define callNN engine2_callNN
+#include "../2/main.c"
+#undef main
+#undef createNN
+#undef callNN
+
+#include "engine2.h"
+
+static NN engine2_nn;
+static int parents_pool_peak = 0;
+
+int engine2_create(int nin, int nout, int nlayers, int num_neurons) {
+    if (engine2_createNN(nin, nout, nlayers, &engine2_nn, num_neurons) != 0) {
+        return -1;
+    }
+
+    // Leaky ReLU for the hidden layers, like 3/MLP.c
+    for(int i = 0; i < nlayers - 1; i++) {
+        for(int j = 0; j < engine2_nn.layers[i]->nout; j++) {
+            engine2_nn.layers[i]->neurons[j]->activation = 'R';
+        }
+    }
+    return parameters_length;
+}
+
+int engine2_set_parameters(const double* params, int n) {
+    if (n != parameters_length) {
+        fprintf(stderr, "Expected %d parameters, got %d\n", parameters_length, n);
+        return -1;
+    }
+    for(int i = 0; i < n; i++) {
+        parameters[i]->value = (float)params[i];
+    }
+    return 0;
+}
+
+double engine2_grad(double* inputs[], double* targets[], int samples_count, double* grads) {
+    int nin = engine2_nn.nin;
+    int nout = engine2_nn.nout;
+    double total_loss = 0.0;
+
+    zeroGrads();
+    BackpropValue **x = malloc(sizeof(BackpropValue*) * nin);
+    BackpropValue **outputs = malloc(sizeof(BackpropValue*) * nout);
+
+    for(int s = 0; s < samples_count; s++) {
+        resetPools();
+
+        for(int i = 0; i < nin; i++) {
+            x[i] = getBackpropPtr();
+            createValue((float)inputs[s][i], x[i]);
+        }
+        engine2_callNN(&engine2_nn, x, outputs);
+
+        BackpropValue *loss = getBackpropPtr();
+        createValue(0.0f, loss);
+        for(int i = 0; i < nout; i++) {
+            BackpropValue *target = getBackpropPtr();
+            createValue((float)targets[s][i], target);
+
+            BackpropValue *error = getBackpropPtr();
+            createValue(0.0f, error);
+            subtractValues(outputs[i], target, error);
+
+            BackpropValue *squared = getBackpropPtr();
+            createValue(0.0f, squared);
+            multiplyValues(error, error, squared);
+
+            BackpropValue *sum = getBackpropPtr();
+            createValue(0.0f, sum);
+            addValues(loss, squared, sum);
+            loss = sum;
+        }
+        total_loss += loss->value;
+
+        if (parents_pool_index > parents_pool_peak) {
+            parents_pool_peak = parents_pool_index;
+        }
+
+        loss->grad = 1.0f;
+        backwardValues(&loss, 1);
+    }
+
+    for(int i = 0; i < parameters_length; i++) {
+        grads[i] = parameters[i]->grad;
+    }
+
+    free(x);
+    free(outputs);
+    return total_loss;
+}
+
+long engine2_peak_bytes() {
+    return (long)backprop_pool_peak * sizeof(BackpropValue) + (long)parents_pool_peak * sizeof(BackpropValue*)
+        + (long)parameters_length * (sizeof(BackpropValue) + sizeof(BackpropValue*));
+}
@@ -0,0 +1,19 @@
+#ifndef ENGINE2_H
+#define ENGINE2_H
+
+// Wrapper around the scalar BackpropValue engine of 2/main.c, it is built
+// with the same layout as the MLP of 3/ (leaky ReLU hidden layers, tanh output)
+// Parameters are ordered layer by layer, neuron by neuron, weights then bias.
+
+int engine2_create(int nin, int nout, int nlayers, int num_neurons);
+
+int engine2_set_parameters(const double* params, int n);
+
+// Sum of the squared errors over every sample, the gradient of every
+// parameter is written to grads
+double engine2_grad(double* inputs[], double* targets[], int samples_count, double* grads);
+
+// Bytes of graph values and parent pointers alive at the peak of a step
+long engine2_peak_bytes();
+
+#endif
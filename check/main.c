@@ -0,0 +1,211 @@
+// Differential check of the engines: builds the same network with the same
+// weights in 3/MLP.c and in the BackpropValue engine of 2/, compares their
+// gradients against each other and against central finite differences, and
+// reports the time and memory of one gradient step of each engine.
+//
+// gcc -O2 main.c engine2.c ../3/MLP.c ../3/timer.c ../3/samples.c -lm -o check
+// ./check [nin] [num_neurons] [nlayers] [nout] [samples] [-p net.txt]
+//
+// The engine of 2/ keeps a whole sample graph in its fixed pools, so it only
+// fits small networks (MAX_BACKPROP_POOL_SIZE values).
+//
+// With -p, the network, the samples and the gradients of 3/ are written to
+// net.txt so that check.py can compare them with the Value engine of 1/.
+
+#include "../3/MLP.h"
+#include "../3/timer.h"
+#include "../3/samples.h"
+#include "engine2.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define TYPE double
+
+#define EPSILON 1e-5
+#define TOLERANCE_FD 1e-6 // 3/ against finite differences
+#define TOLERANCE_FLOAT 1e-3 // 2/ computes in float
+#define TIMING_STEPS 20
+
+int count_parameters(NN* nn) {
+    int count = 0;
+    for (int i = 0; i < nn->num_layers; i++) {
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
+            count += nn->layers[i].neurons[j].num_weights + 1;
+        }
+    }
+    return count;
+}
+
+// Parameters ordered like the parameters array of 2/: weights then bias of every neuron
+TYPE* parameter_ptr(NN* nn, int index) {
+    for (int i = 0; i < nn->num_layers; i++) {
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
+            Neuron* neuron = &nn->layers[i].neurons[j];
+            if (index < neuron->num_weights) {
+                return &neuron->weights[index];
+            }
+            if (index == neuron->num_weights) {
+                return &neuron->bias;
+            }
+            index -= neuron->num_weights + 1;
+        }
+    }
+    return NULL;
+}
+
+void flatten(NN* nn, TYPE* params, TYPE* grads) {
+    int p = 0;
+    for (int i = 0; i < nn->num_layers; i++) {
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
+            Neuron* neuron = &nn->layers[i].neurons[j];
+            for (int k = 0; k < neuron->num_weights; k++) {
+                params[p] = neuron->weights[k];
+                grads[p] = neuron->weights_grad[k];
+                p++;
+            }
+            params[p] = neuron->bias;
+            grads[p] = neuron->bias_grad;
+            p++;
+        }
+    }
+}
+
+TYPE loss(NN* nn, TYPE* inputs[], TYPE* targets[], int samples_count, int nout) {
+    TYPE total_loss = 0.0;
+    for (int j = 0; j < samples_count; j++) {
+        TYPE* output = callNN(nn, inputs[j]);
+        for (int k = 0; k < nout; k++) {
+            TYPE error = targets[j][k] - output[k];
+            total_loss += error * error;
+        }
+        free(output);
+    }
+    return total_loss;
+}
+
+// Error that is absolute for small gradients and relative for large ones
+TYPE grad_error(TYPE a, TYPE b) {
+    return fabs(a - b) / fmax(1.0, fabs(a) + fabs(b));
+}
+
+int export_network(const char* filename, int nin, int num_neurons, int nlayers, int nout, int samples_count,
+                   TYPE* params, TYPE* grads, int num_params, TYPE* inputs[], TYPE* targets[]) {
+    FILE* fp = fopen(filename, "w");
+    if (!fp) {
+        printf("Cannot open %s\n", filename);
+        return -1;
+    }
+
+    fprintf(fp, "%d %d %d %d %d\n", nin, num_neurons, nlayers, nout, samples_count);
+    for (int i = 0; i < num_params; i++) fprintf(fp, "%.17g ", params[i]);
+    fprintf(fp, "\n");
+    for (int i = 0; i < num_params; i++) fprintf(fp, "%.17g ", grads[i]);
+    fprintf(fp, "\n");
+    for (int j = 0; j < samples_count; j++) {
+        for (int k = 0; k < nin; k++) fprintf(fp, "%.17g ", inputs[j][k]);
+        fprintf(fp, "\n");
+        for (int k = 0; k < nout; k++) fprintf(fp, "%.17g ", targets[j][k]);
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int sizes[5] = {8, 16, 3, 4, 4}; // nin, num_neurons, nlayers, nout, samples
+    int num_sizes = 0;
+    const char* export_filename = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            export_filename = argv[++i];
+        } else if (num_sizes < 5) {
+            sizes[num_sizes++] = atoi(argv[i]);
+        }
+    }
+    int nin = sizes[0], num_neurons = sizes[1], nlayers = sizes[2], nout = sizes[3], samples_count = sizes[4];
+
+    TYPE** inputs;
+    TYPE** targets;
+    srand(42);
+    random_samples(samples_count, nin, nout, &inputs, &targets);
+
+    NN* nn = createNN(nin, nout, nlayers, num_neurons);
+    int num_params = count_parameters(nn);
+    if (engine2_create(nin, nout, nlayers, num_neurons) != num_params) {
+        printf("Engines disagree on the number of parameters\n");
+        return 1;
+    }
+
+    TYPE* params = malloc(num_params * sizeof(TYPE));
+    TYPE* grads3 = malloc(num_params * sizeof(TYPE));
+    TYPE* grads2 = malloc(num_params * sizeof(TYPE));
+
+    reset_grad(nn);
+    calculate_grad(nn, inputs, targets, samples_count);
+    flatten(nn, params, grads3);
+    engine2_set_parameters(params, num_params);
+    TYPE loss2 = engine2_grad(inputs, targets, samples_count, grads2);
+    TYPE loss3 = loss(nn, inputs, targets, samples_count, nout);
+
+    printf("%d parameters, %d samples\n", num_params, samples_count);
+    printf("Loss: 3/ %f, 2/ %f\n", loss3, loss2);
+
+    // Gradients
+    TYPE max_error_fd = 0.0, max_error_2 = 0.0;
+    for (int i = 0; i < num_params; i++) {
+        TYPE* p = parameter_ptr(nn, i);
+        TYPE saved = *p;
+        *p = saved + EPSILON;
+        TYPE loss_plus = loss(nn, inputs, targets, samples_count, nout);
+        *p = saved - EPSILON;
+        TYPE loss_minus = loss(nn, inputs, targets, samples_count, nout);
+        *p = saved;
+
+        TYPE fd = (loss_plus - loss_minus) / (2.0 * EPSILON);
+        max_error_fd = fmax(max_error_fd, grad_error(grads3[i], fd));
+        max_error_2 = fmax(max_error_2, grad_error(grads3[i], grads2[i]));
+    }
+    int failed = 0;
+    printf("Max gradient error 3/ vs finite differences: %e %s\n", max_error_fd,
+           (max_error_fd <= TOLERANCE_FD) ? "OK" : "FAILED");
+    printf("Max gradient error 2/ vs 3/: %e %s\n", max_error_2,
+           (max_error_2 <= TOLERANCE_FLOAT) ? "OK" : "FAILED");
+    failed |= max_error_fd > TOLERANCE_FD;
+    failed |= max_error_2 > TOLERANCE_FLOAT;
+
+    // Time of one gradient step (all samples)
+    double start = now();
+    for (int i = 0; i < TIMING_STEPS; i++) {
+        reset_grad(nn);
+        calculate_grad(nn, inputs, targets, samples_count);
+    }
+    double time3 = (now() - start) / TIMING_STEPS;
+
+    start = now();
+    for (int i = 0; i < TIMING_STEPS; i++) {
+        engine2_grad(inputs, targets, samples_count, grads2);
+    }
+    double time2 = (now() - start) / TIMING_STEPS;
+
+    long bytes3 = sizeof(NN) + nlayers * sizeof(Layer);
+    for (int i = 0; i < nn->num_layers; i++) {
+        bytes3 += nn->layers[i].num_neurons * sizeof(Neuron);
+        for (int j = 0; j < nn->layers[i].num_neurons; j++) {
+            bytes3 += 2 * nn->layers[i].neurons[j].num_weights * sizeof(TYPE);
+        }
+    }
+
+    printf("3/: %10.3f ms/step, %10ld bytes\n", time3 * 1e3, bytes3);
+    printf("2/: %10.3f ms/step, %10ld bytes\n", time2 * 1e3, engine2_peak_bytes());
+
+    if (export_filename != NULL) {
+        export_network(export_filename, nin, num_neurons, nlayers, nout, samples_count,
+                       params, grads3, num_params, inputs, targets);
+    }
+
+    return failed;
+}